@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "program_config.h"
+#include "work_pool.h"
+
+// First occurrence of `needle` in [haystack, haystack + size), or nullptr.
+// With SSE2, sixteen candidate positions at a time are filtered on the
+// needle's first and last byte, and only survivors are compared in full.
+inline const char* findSubstring(const char* haystack, size_t size, std::string_view needle) {
+    size_t length = needle.size();
+    if (length == 0) return haystack;
+    if (length > size) return nullptr;
+    if (length == 1) return static_cast<const char*>(std::memchr(haystack, needle[0], size));
+    size_t lastStart = size - length;
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i first = _mm_set1_epi8(needle.front());
+    const __m128i last = _mm_set1_epi8(needle.back());
+    for (; i + 16 <= lastStart + 1; i += 16) {
+        __m128i heads = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i));
+        __m128i tails = _mm_loadu_si128(reinterpret_cast<const __m128i*>(haystack + i + length - 1));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(heads, first), _mm_cmpeq_epi8(tails, last))));
+        while (mask != 0) {
+            unsigned bit = static_cast<unsigned>(__builtin_ctz(mask));
+            if (std::memcmp(haystack + i + bit + 1, needle.data() + 1, length - 2) == 0) return haystack + i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i <= lastStart; ++i) {
+        if (haystack[i] == needle.front() && haystack[i + length - 1] == needle.back() &&
+            std::memcmp(haystack + i + 1, needle.data() + 1, length - 2) == 0) {
+            return haystack + i;
+        }
+    }
+    return nullptr;
+}
+
+struct DebugScanOptions {
+    std::string root = ".";
+    std::string sourceDirectory = "src"; // under root; searched for the error signature
+    size_t tailLines = 10;               // per *.log file anywhere under root
+    size_t maxMatches = 64;              // in path order, across all files
+    size_t maxContextBytes = 240;
+};
+
+struct LogTail {
+    std::string file;
+    std::vector<std::string> lines;
+};
+
+struct DebugScanResult {
+    std::vector<DebugMatch> matches;
+    std::vector<LogTail> tails;
+    size_t filesSeen = 0;
+    size_t filesScanned = 0; // read by this scan; the rest were unchanged
+    bool truncated = false;  // more than maxMatches matches
+};
+
+// The DEBUGGING phase's look at the tree, in place of
+// `find . -name '*.log' -exec tail -n 10 {} \;` and
+// `grep -r '<lastErrorMessage>' ./src/`: one walk of the tree, files mapped
+// rather than read, logs tailed backwards from EOF and the signature
+// searched as bytes, so quotes in an error message need no escaping.
+//
+// Every file's tail and matches are kept in an index keyed by path and
+// checked against mtime and size, so a repeated scan (the next debug attempt
+// for the same error) only maps files that changed. Changing the signature
+// invalidates the source matches. Dot-directories are skipped and symlinks
+// are not followed. Not thread-safe; stale files are read on `pool`.
+class DebugScanner {
+public:
+    DebugScanner(DebugScanOptions scanOptions, WorkStealingPool& workers) : options(std::move(scanOptions)), pool(workers) {}
+
+    const DebugScanOptions& settings() const { return options; }
+
+    void scan(std::string_view signature, DebugScanResult& result) {
+        if (signature != indexedSignature) {
+            indexedSignature.assign(signature);
+            for (auto& entry : index) entry.second.searched = false;
+        }
+        walked.clear();
+        walk(options.root, "");
+        std::sort(walked.begin(), walked.end(), [](const WalkedFile& a, const WalkedFile& b) { return a.path < b.path; });
+
+        stale.clear();
+        for (const WalkedFile& file : walked) {
+            auto found = index.find(file.path);
+            bool fresh = found != index.end() && found->second.mtimeNs == file.mtimeNs && found->second.size == file.size &&
+                         (!file.source || found->second.searched);
+            if (!fresh) stale.push_back(&file);
+        }
+        scanned.assign(stale.size(), IndexedFile());
+        pool.parallelFor(stale.size(), [&](size_t i) { load(*stale[i], scanned[i]); });
+        for (size_t i = 0; i < stale.size(); ++i) index[stale[i]->path] = std::move(scanned[i]);
+        if (index.size() > walked.size()) {
+            // Files were deleted (or no longer qualify); drop their entries.
+            auto byPath = [](const WalkedFile& file, const std::string& path) { return file.path < path; };
+            for (auto entry = index.begin(); entry != index.end();) {
+                auto position = std::lower_bound(walked.begin(), walked.end(), entry->first, byPath);
+                if (position == walked.end() || position->path != entry->first) entry = index.erase(entry);
+                else ++entry;
+            }
+        }
+
+        result.matches.clear();
+        result.tails.clear();
+        result.truncated = false;
+        result.filesSeen = walked.size();
+        result.filesScanned = stale.size();
+        for (const WalkedFile& file : walked) {
+            const IndexedFile& entry = index.at(file.path);
+            if (file.log) result.tails.push_back({file.path, entry.tail});
+            if (!file.source) continue;
+            for (const DebugMatch& match : entry.matches) {
+                if (result.matches.size() == options.maxMatches) {
+                    result.truncated = true;
+                    break;
+                }
+                result.matches.push_back(match);
+            }
+        }
+    }
+
+    size_t indexedFiles() const { return index.size(); }
+
+private:
+    struct WalkedFile {
+        std::string path; // relative to root
+        int64_t mtimeNs;
+        int64_t size;
+        bool log;
+        bool source;
+    };
+
+    struct IndexedFile {
+        int64_t mtimeNs = -1;
+        int64_t size = -1;
+        bool searched = false;
+        std::vector<std::string> tail;
+        std::vector<DebugMatch> matches;
+    };
+
+    void walk(const std::string& directory, const std::string& relative) {
+        DIR* dir = ::opendir(directory.c_str());
+        if (!dir) return;
+        while (dirent* entry = ::readdir(dir)) {
+            if (entry->d_name[0] == '.') continue;
+            std::string path = directory + "/" + entry->d_name;
+            std::string name = relative.empty() ? entry->d_name : relative + "/" + entry->d_name;
+            struct stat info;
+            if (::lstat(path.c_str(), &info) != 0) continue;
+            if (S_ISDIR(info.st_mode)) {
+                walk(path, name);
+                continue;
+            }
+            if (!S_ISREG(info.st_mode)) continue;
+            bool log = name.size() > 4 && name.compare(name.size() - 4, 4, ".log") == 0;
+            bool source = !indexedSignature.empty() && name.size() > options.sourceDirectory.size() &&
+                          name.compare(0, options.sourceDirectory.size(), options.sourceDirectory) == 0 && name[options.sourceDirectory.size()] == '/';
+            if (!log && !source) continue;
+            int64_t mtimeNs = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+            walked.push_back({std::move(name), mtimeNs, static_cast<int64_t>(info.st_size), log, source});
+        }
+        ::closedir(dir);
+    }
+
+    // Runs on a pool thread; touches only `file` and `out`.
+    void load(const WalkedFile& file, IndexedFile& out) const {
+        out.mtimeNs = file.mtimeNs;
+        out.size = file.size;
+        out.searched = file.source;
+        if (file.size <= 0) return;
+        int fd = ::open((options.root + "/" + file.path).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return;
+        size_t size = static_cast<size_t>(file.size);
+        void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return;
+        const char* data = static_cast<const char*>(mapped);
+        if (file.log) tail(data, size, out.tail);
+        // Like grep, binary files (a NUL near the start) are not searched.
+        if (file.source && !std::memchr(data, '\0', std::min<size_t>(size, 4096))) {
+            ::madvise(mapped, size, MADV_SEQUENTIAL);
+            search(data, size, file.path, out.matches);
+        }
+        ::munmap(mapped, size);
+    }
+
+    void tail(const char* data, size_t size, std::vector<std::string>& lines) const {
+        const char* end = data + size;
+        if (end[-1] == '\n') --end;
+        while (lines.size() < options.tailLines && end > data) {
+            const char* newline = static_cast<const char*>(::memrchr(data, '\n', static_cast<size_t>(end - data)));
+            const char* start = newline ? newline + 1 : data;
+            lines.emplace_back(start, static_cast<size_t>(end - start));
+            if (!newline) break;
+            end = newline;
+        }
+        std::reverse(lines.begin(), lines.end());
+    }
+
+    void search(const char* data, size_t size, const std::string& path, std::vector<DebugMatch>& matches) const {
+        const char* end = data + size;
+        const char* cursor = data;
+        const char* counted = data;
+        uint32_t line = 1;
+        while (matches.size() < options.maxMatches) {
+            const char* hit = findSubstring(cursor, static_cast<size_t>(end - cursor), indexedSignature);
+            if (!hit) break;
+            line += static_cast<uint32_t>(std::count(counted, hit, '\n'));
+            counted = hit;
+            const char* lineStart = static_cast<const char*>(::memrchr(data, '\n', static_cast<size_t>(hit - data)));
+            lineStart = lineStart ? lineStart + 1 : data;
+            const char* lineEnd = static_cast<const char*>(std::memchr(hit, '\n', static_cast<size_t>(end - hit)));
+            if (!lineEnd) lineEnd = end;
+            size_t length = static_cast<size_t>(lineEnd - lineStart);
+            if (length > 0 && lineStart[length - 1] == '\r') --length;
+            matches.push_back({path, line, std::string(lineStart, std::min(length, options.maxContextBytes))});
+            // One match per line, as grep reports it.
+            cursor = lineEnd;
+        }
+    }
+
+    DebugScanOptions options;
+    WorkStealingPool& pool;
+    std::string indexedSignature;
+    std::unordered_map<std::string, IndexedFile> index;
+
+    // Reused across scans.
+    std::vector<WalkedFile> walked;
+    std::vector<const WalkedFile*> stale;
+    std::vector<IndexedFile> scanned;
+};
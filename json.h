@@ -0,0 +1,615 @@
+#pragma once
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+enum class JsonType {
+    Null,
+    Bool,
+    Number,
+    String,
+    Array,
+    Object
+};
+
+// One entry on the parse tape. Containers are followed by their children and
+// store the tape index one past their last descendant in `end`, so a sibling
+// can be skipped in O(1). Object children alternate key (String) and value.
+struct JsonNode {
+    JsonType type;
+    uint32_t end;
+    std::string_view text; // raw token for Number/Bool, decoded contents for String
+};
+
+class JsonDocument;
+
+// Lightweight handle to a node inside a JsonDocument. An invalid ref is
+// returned for missing keys, so lookups can be chained without checks.
+class JsonRef {
+public:
+    JsonRef() : doc(nullptr), index(0) {}
+    JsonRef(const JsonDocument* document, uint32_t nodeIndex) : doc(document), index(nodeIndex) {}
+
+    bool valid() const { return doc != nullptr; }
+    explicit operator bool() const { return valid(); }
+
+    JsonType type() const;
+    bool isNull() const { return valid() && type() == JsonType::Null; }
+    bool isObject() const { return valid() && type() == JsonType::Object; }
+    bool isArray() const { return valid() && type() == JsonType::Array; }
+    bool isString() const { return valid() && type() == JsonType::String; }
+
+    JsonRef operator[](std::string_view key) const;
+    JsonRef at(size_t position) const;
+    size_t size() const;
+
+    // Accessors are lenient about representation: the legacy writer stored
+    // every value as a string, so "12" reads as a number and "true" as a bool.
+    std::string_view asString(std::string_view fallback = {}) const;
+    double asNumber(double fallback = 0.0) const;
+    long long asInt(long long fallback = 0) const;
+    bool asBool(bool fallback = false) const;
+
+    template <typename Fn> void forEachMember(Fn&& fn) const;
+    template <typename Fn> void forEachElement(Fn&& fn) const;
+
+private:
+    const JsonNode& node() const;
+
+    const JsonDocument* doc;
+    uint32_t index;
+};
+
+// Single-pass JSON parser. String values are views into the input buffer when
+// they contain no escapes, otherwise into an arena owned by the document, so
+// the input must outlive the document's refs. Reusing a document across
+// parses keeps its tape and arena capacity and avoids steady-state allocations.
+class JsonDocument {
+public:
+    static constexpr int kMaxDepth = 256;
+
+    bool parse(std::string_view input) {
+        nodes.clear();
+        arena.clear();
+        errorMessage.clear();
+        begin = input.data();
+        cur = begin;
+        last = begin + input.size();
+        inputSize = input.size();
+
+        skipWhitespace();
+        if (!parseValue(0)) return false;
+        skipWhitespace();
+        if (cur != last) return fail("unexpected trailing characters");
+        return true;
+    }
+
+    JsonRef root() const { return nodes.empty() ? JsonRef() : JsonRef(this, 0); }
+    const std::string& error() const { return errorMessage; }
+    const std::vector<JsonNode>& tape() const { return nodes; }
+
+private:
+    friend class JsonRef;
+
+    bool fail(const char* what) {
+        errorMessage = std::string(what) + " at offset " + std::to_string(cur - begin);
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (cur != last && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t')) ++cur;
+    }
+
+    bool parseValue(int depth) {
+        if (cur == last) return fail("unexpected end of input");
+        switch (*cur) {
+            case '{': return parseObject(depth + 1);
+            case '[': return parseArray(depth + 1);
+            case '"': return parseString();
+            case 't': return parseLiteral("true", JsonType::Bool);
+            case 'f': return parseLiteral("false", JsonType::Bool);
+            case 'n': return parseLiteral("null", JsonType::Null);
+            default: return parseNumber();
+        }
+    }
+
+    bool parseObject(int depth) {
+        if (depth > kMaxDepth) return fail("nesting too deep");
+        size_t self = pushNode(JsonType::Object, {});
+        ++cur;
+        skipWhitespace();
+        if (cur != last && *cur == '}') {
+            ++cur;
+            nodes[self].end = static_cast<uint32_t>(nodes.size());
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (cur == last || *cur != '"') return fail("expected object key");
+            if (!parseString()) return false;
+            skipWhitespace();
+            if (cur == last || *cur != ':') return fail("expected ':' after object key");
+            ++cur;
+            skipWhitespace();
+            if (!parseValue(depth)) return false;
+            skipWhitespace();
+            if (cur == last) return fail("unterminated object");
+            if (*cur == ',') { ++cur; continue; }
+            if (*cur == '}') { ++cur; break; }
+            return fail("expected ',' or '}' in object");
+        }
+        nodes[self].end = static_cast<uint32_t>(nodes.size());
+        return true;
+    }
+
+    bool parseArray(int depth) {
+        if (depth > kMaxDepth) return fail("nesting too deep");
+        size_t self = pushNode(JsonType::Array, {});
+        ++cur;
+        skipWhitespace();
+        if (cur != last && *cur == ']') {
+            ++cur;
+            nodes[self].end = static_cast<uint32_t>(nodes.size());
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (!parseValue(depth)) return false;
+            skipWhitespace();
+            if (cur == last) return fail("unterminated array");
+            if (*cur == ',') { ++cur; continue; }
+            if (*cur == ']') { ++cur; break; }
+            return fail("expected ',' or ']' in array");
+        }
+        nodes[self].end = static_cast<uint32_t>(nodes.size());
+        return true;
+    }
+
+    bool parseString() {
+        const char* start = ++cur;
+        while (cur != last && *cur != '"' && *cur != '\\') {
+            if (static_cast<unsigned char>(*cur) < 0x20) return fail("control character in string");
+            ++cur;
+        }
+        if (cur == last) return fail("unterminated string");
+        if (*cur == '"') {
+            pushNode(JsonType::String, std::string_view(start, cur - start));
+            ++cur;
+            return true;
+        }
+        return parseEscapedString(start);
+    }
+
+    // Slow path: decode into the arena. Decoded text is never longer than its
+    // source, so reserving the input size up front keeps earlier views valid.
+    bool parseEscapedString(const char* start) {
+        if (arena.empty() && arena.capacity() < inputSize) arena.reserve(inputSize);
+        size_t offset = arena.size();
+        arena.append(start, cur - start);
+        while (cur != last && *cur != '"') {
+            char c = *cur;
+            if (static_cast<unsigned char>(c) < 0x20) return fail("control character in string");
+            if (c != '\\') {
+                const char* run = cur;
+                while (cur != last && *cur != '"' && *cur != '\\' && static_cast<unsigned char>(*cur) >= 0x20) ++cur;
+                arena.append(run, cur - run);
+                continue;
+            }
+            if (++cur == last) break;
+            switch (*cur) {
+                case '"': arena.push_back('"'); break;
+                case '\\': arena.push_back('\\'); break;
+                case '/': arena.push_back('/'); break;
+                case 'b': arena.push_back('\b'); break;
+                case 'f': arena.push_back('\f'); break;
+                case 'n': arena.push_back('\n'); break;
+                case 'r': arena.push_back('\r'); break;
+                case 't': arena.push_back('\t'); break;
+                case 'u':
+                    if (!parseUnicodeEscape()) return false;
+                    continue;
+                default: return fail("invalid escape sequence");
+            }
+            ++cur;
+        }
+        if (cur == last) return fail("unterminated string");
+        pushNode(JsonType::String, std::string_view(arena.data() + offset, arena.size() - offset));
+        ++cur;
+        return true;
+    }
+
+    bool readHex4(uint32_t& out) {
+        if (last - cur < 4) return fail("truncated unicode escape");
+        out = 0;
+        for (int i = 0; i < 4; ++i, ++cur) {
+            char c = *cur;
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= c - '0';
+            else if (c >= 'a' && c <= 'f') out |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F') out |= c - 'A' + 10;
+            else return fail("invalid unicode escape");
+        }
+        return true;
+    }
+
+    // Called with `cur` on the 'u'; leaves `cur` after the last hex digit.
+    bool parseUnicodeEscape() {
+        ++cur;
+        uint32_t code = 0;
+        if (!readHex4(code)) return false;
+        if (code >= 0xD800 && code <= 0xDBFF) {
+            uint32_t low = 0;
+            if (last - cur < 6 || cur[0] != '\\' || cur[1] != 'u') return fail("unpaired surrogate");
+            cur += 2;
+            if (!readHex4(low)) return false;
+            if (low < 0xDC00 || low > 0xDFFF) return fail("unpaired surrogate");
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+        } else if (code >= 0xDC00 && code <= 0xDFFF) {
+            return fail("unpaired surrogate");
+        }
+        if (code < 0x80) {
+            arena.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            arena.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            arena.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            arena.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            arena.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            arena.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            arena.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            arena.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            arena.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            arena.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+        return true;
+    }
+
+    bool parseLiteral(std::string_view word, JsonType type) {
+        if (static_cast<size_t>(last - cur) < word.size() || std::memcmp(cur, word.data(), word.size()) != 0) {
+            return fail("invalid literal");
+        }
+        pushNode(type, std::string_view(cur, word.size()));
+        cur += word.size();
+        return true;
+    }
+
+    static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+    bool parseNumber() {
+        const char* start = cur;
+        if (cur != last && *cur == '-') ++cur;
+        if (cur == last || !isDigit(*cur)) return fail("unexpected character");
+        if (*cur == '0') {
+            ++cur;
+        } else {
+            while (cur != last && isDigit(*cur)) ++cur;
+        }
+        if (cur != last && *cur == '.') {
+            ++cur;
+            if (cur == last || !isDigit(*cur)) return fail("invalid number");
+            while (cur != last && isDigit(*cur)) ++cur;
+        }
+        if (cur != last && (*cur == 'e' || *cur == 'E')) {
+            ++cur;
+            if (cur != last && (*cur == '+' || *cur == '-')) ++cur;
+            if (cur == last || !isDigit(*cur)) return fail("invalid number");
+            while (cur != last && isDigit(*cur)) ++cur;
+        }
+        pushNode(JsonType::Number, std::string_view(start, cur - start));
+        return true;
+    }
+
+    size_t pushNode(JsonType type, std::string_view text) {
+        nodes.push_back(JsonNode{type, static_cast<uint32_t>(nodes.size() + 1), text});
+        return nodes.size() - 1;
+    }
+
+    std::vector<JsonNode> nodes;
+    std::string arena;
+    std::string errorMessage;
+    const char* begin = nullptr;
+    const char* cur = nullptr;
+    const char* last = nullptr;
+    size_t inputSize = 0;
+};
+
+inline const JsonNode& JsonRef::node() const { return doc->nodes[index]; }
+
+inline JsonType JsonRef::type() const { return node().type; }
+
+inline JsonRef JsonRef::operator[](std::string_view key) const {
+    if (!isObject()) return JsonRef();
+    uint32_t end = node().end;
+    for (uint32_t i = index + 1; i < end; i = doc->nodes[i + 1].end) {
+        if (doc->nodes[i].text == key) return JsonRef(doc, i + 1);
+    }
+    return JsonRef();
+}
+
+inline JsonRef JsonRef::at(size_t position) const {
+    if (!isArray()) return JsonRef();
+    uint32_t end = node().end;
+    for (uint32_t i = index + 1; i < end; i = doc->nodes[i].end) {
+        if (position-- == 0) return JsonRef(doc, i);
+    }
+    return JsonRef();
+}
+
+inline size_t JsonRef::size() const {
+    if (!valid()) return 0;
+    JsonType t = type();
+    if (t != JsonType::Array && t != JsonType::Object) return 0;
+    size_t count = 0;
+    uint32_t end = node().end;
+    for (uint32_t i = index + 1; i < end; i = doc->nodes[i].end) ++count;
+    return t == JsonType::Object ? count / 2 : count;
+}
+
+inline std::string_view JsonRef::asString(std::string_view fallback) const {
+    if (!valid()) return fallback;
+    JsonType t = type();
+    if (t == JsonType::String || t == JsonType::Number || t == JsonType::Bool) return node().text;
+    return fallback;
+}
+
+inline double JsonRef::asNumber(double fallback) const {
+    if (!valid() || (type() != JsonType::Number && type() != JsonType::String)) return fallback;
+    std::string_view text = node().text;
+    while (!text.empty() && (text.front() == ' ' || text.front() == '+')) text.remove_prefix(1);
+    double value = fallback;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    return result.ec == std::errc() ? value : fallback;
+}
+
+inline long long JsonRef::asInt(long long fallback) const {
+    if (!valid() || (type() != JsonType::Number && type() != JsonType::String)) return fallback;
+    std::string_view text = node().text;
+    long long value = 0;
+    auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec == std::errc() && result.ptr == text.data() + text.size()) return value;
+    double asDouble = asNumber(static_cast<double>(fallback));
+    return static_cast<long long>(asDouble);
+}
+
+inline bool JsonRef::asBool(bool fallback) const {
+    if (!valid()) return fallback;
+    JsonType t = type();
+    if (t != JsonType::Bool && t != JsonType::String) return fallback;
+    std::string_view text = node().text;
+    if (text == "true") return true;
+    if (text == "false") return false;
+    return fallback;
+}
+
+template <typename Fn>
+void JsonRef::forEachMember(Fn&& fn) const {
+    if (!isObject()) return;
+    uint32_t end = node().end;
+    for (uint32_t i = index + 1; i < end; i = doc->nodes[i + 1].end) {
+        fn(doc->nodes[i].text, JsonRef(doc, i + 1));
+    }
+}
+
+template <typename Fn>
+void JsonRef::forEachElement(Fn&& fn) const {
+    if (!isArray()) return;
+    uint32_t end = node().end;
+    for (uint32_t i = index + 1; i < end; i = doc->nodes[i].end) {
+        fn(JsonRef(doc, i));
+    }
+}
+
+// Locates the first complete top-level object in a growing buffer, such as
+// subprocess output that is still arriving. Each feed() only scans bytes
+// appended since the previous call, so the object can be handed to
+// JsonDocument as soon as its closing brace arrives. An object must start on
+// its own line, so braces inside surrounding log lines are skipped.
+class JsonStreamScanner {
+public:
+    void reset() {
+        scanned = 0;
+        depth = 0;
+        inString = false;
+        escaped = false;
+        atLineStart = true;
+        start = std::string_view::npos;
+        finish = std::string_view::npos;
+    }
+
+    // `buffer` must start with the bytes passed to earlier calls.
+    bool feed(std::string_view buffer) {
+        if (complete()) return true;
+        const char* data = buffer.data();
+        for (size_t i = scanned; i < buffer.size(); ++i) {
+            char c = data[i];
+            if (start == std::string_view::npos) {
+                if (c == '{' && atLineStart) {
+                    start = i;
+                    depth = 1;
+                } else if (c == '\n') {
+                    atLineStart = true;
+                } else if (c != ' ' && c != '\t' && c != '\r') {
+                    atLineStart = false;
+                }
+                continue;
+            }
+            if (inString) {
+                if (escaped) escaped = false;
+                else if (c == '\\') escaped = true;
+                else if (c == '"') inString = false;
+                continue;
+            }
+            if (c == '"') inString = true;
+            else if (c == '{' || c == '[') ++depth;
+            else if ((c == '}' || c == ']') && --depth == 0) {
+                finish = i + 1;
+                scanned = finish;
+                return true;
+            }
+        }
+        scanned = buffer.size();
+        return false;
+    }
+
+    bool complete() const { return finish != std::string_view::npos; }
+    std::string_view object(std::string_view buffer) const {
+        return complete() ? buffer.substr(start, finish - start) : std::string_view();
+    }
+
+private:
+    size_t scanned = 0;
+    int depth = 0;
+    bool inString = false;
+    bool escaped = false;
+    bool atLineStart = true;
+    size_t start = std::string_view::npos;
+    size_t finish = std::string_view::npos;
+};
+
+// Appends `text` to `out` as the body of a JSON string literal. Unescaped
+// runs are copied in bulk; the table maps each byte to its short escape, 'u'
+// for a \u00XX escape, or 0 when it can be copied as is.
+inline void appendJsonEscaped(std::string& out, std::string_view text) {
+    struct EscapeTable {
+        char code[256];
+        constexpr EscapeTable() : code() {
+            for (int c = 0; c < 0x20; ++c) code[c] = 'u';
+            code[static_cast<int>('"')] = '"';
+            code[static_cast<int>('\\')] = '\\';
+            code[static_cast<int>('\n')] = 'n';
+            code[static_cast<int>('\r')] = 'r';
+            code[static_cast<int>('\t')] = 't';
+            code[static_cast<int>('\b')] = 'b';
+            code[static_cast<int>('\f')] = 'f';
+        }
+    };
+    static constexpr EscapeTable table;
+    static const char hex[] = "0123456789abcdef";
+
+    out.reserve(out.size() + text.size() + 2);
+    const char* data = text.data();
+    size_t size = text.size();
+    size_t runStart = 0;
+    for (size_t i = 0; i < size; ++i) {
+        char code = table.code[static_cast<unsigned char>(data[i])];
+        if (code == 0) continue;
+        out.append(data + runStart, i - runStart);
+        runStart = i + 1;
+        if (code == 'u') {
+            char escape[6] = {'\\', 'u', '0', '0', hex[static_cast<unsigned char>(data[i]) >> 4], hex[data[i] & 0xF]};
+            out.append(escape, 6);
+        } else {
+            char escape[2] = {'\\', code};
+            out.append(escape, 2);
+        }
+    }
+    out.append(data + runStart, size - runStart);
+}
+
+// Streaming writer that appends straight into a caller-owned buffer. Pretty
+// output matches the layout of the original config.json writer.
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& output, bool prettyPrint = true)
+        : out(output), pretty(prettyPrint), depth(0), needComma(false), afterKey(false) {}
+
+    void beginObject() { openContainer('{'); }
+    void endObject() { closeContainer('}'); }
+    void beginArray() { openContainer('['); }
+    void endArray() { closeContainer(']'); }
+
+    void key(std::string_view name) {
+        separate();
+        out.push_back('"');
+        appendJsonEscaped(out, name);
+        out += pretty ? "\": " : "\":";
+        afterKey = true;
+    }
+
+    void value(std::string_view text) {
+        separate();
+        out.push_back('"');
+        appendJsonEscaped(out, text);
+        out.push_back('"');
+    }
+    void value(const std::string& text) { value(std::string_view(text)); }
+    void value(const char* text) { value(std::string_view(text)); }
+
+    void value(bool flag) {
+        separate();
+        out += flag ? "true" : "false";
+    }
+
+    void value(double number) {
+        separate();
+        if (number != number || number - number != 0) { // NaN or infinity
+            out += "null";
+            return;
+        }
+        char buffer[32];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+        out.append(buffer, result.ptr);
+    }
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>, int> = 0>
+    void value(T number) {
+        separate();
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+        out.append(buffer, result.ptr);
+    }
+
+    void null() {
+        separate();
+        out += "null";
+    }
+
+    template <typename T>
+    void member(std::string_view name, const T& v) {
+        key(name);
+        value(v);
+    }
+
+private:
+    void newline() {
+        if (!pretty) return;
+        out.push_back('\n');
+        out.append(static_cast<size_t>(depth) * 4, ' ');
+    }
+
+    void separate() {
+        if (afterKey) {
+            afterKey = false;
+            return;
+        }
+        if (needComma) out.push_back(',');
+        if (depth > 0) newline();
+        needComma = true;
+    }
+
+    void openContainer(char open) {
+        separate();
+        out.push_back(open);
+        ++depth;
+        needComma = false;
+    }
+
+    void closeContainer(char close) {
+        --depth;
+        if (needComma) newline();
+        out.push_back(close);
+        needComma = true;
+    }
+
+    std::string& out;
+    bool pretty;
+    int depth;
+    bool needComma;
+    bool afterKey;
+};
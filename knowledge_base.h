@@ -0,0 +1,591 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "program_config.h"
+#include "result_cache.h"
+#include "state_journal.h"
+
+constexpr size_t kMaxTokenLength = 32;
+
+inline bool isStopWord(std::string_view token) {
+    static constexpr std::string_view stopWords[] = {
+        "an", "and", "are", "as", "at", "be", "by", "do", "does", "for", "from", "how", "in", "is",
+        "it", "of", "on", "or", "that", "the", "this", "to", "was", "what", "which", "with"};
+    if (token.size() > 5) return false;
+    for (std::string_view word : stopWords) {
+        if (word == token) return true;
+    }
+    return false;
+}
+
+// Calls `fn(token)` for each lowercased ASCII alphanumeric run of 2 to
+// kMaxTokenLength characters that is not a stop word. Longer runs are
+// dropped. The view passed to `fn` is only valid during the call.
+template <typename Fn>
+void forEachToken(std::string_view text, Fn&& fn) {
+    char token[kMaxTokenLength];
+    size_t length = 0;
+    bool overlong = false;
+    auto emit = [&]() {
+        std::string_view word(token, length);
+        if (length >= 2 && !overlong && !isStopWord(word)) fn(word);
+        length = 0;
+        overlong = false;
+    };
+    for (char c : text) {
+        unsigned char u = static_cast<unsigned char>(c);
+        bool alnum = (u >= '0' && u <= '9') || (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+        if (!alnum) {
+            emit();
+        } else if (length < kMaxTokenLength) {
+            token[length++] = static_cast<char>(u >= 'A' && u <= 'Z' ? u + ('a' - 'A') : u);
+        } else {
+            overlong = true;
+        }
+    }
+    emit();
+}
+
+struct KnowledgeBaseOptions {
+    std::string directory = ".knowledge";
+    size_t flushEveryPassages = 4096; // smallest unflushed batch that triggers a segment rewrite
+};
+
+struct KnowledgeHit {
+    uint32_t passage = 0;
+    double score = 0.0;
+    int iteration = 0;
+    std::string topic;
+    std::string text;
+};
+
+// Per-caller working memory for KnowledgeBase::search, so several threads
+// can query one knowledge base at once.
+struct KnowledgeSearchScratch {
+    std::vector<std::string> queryTerms;
+    std::vector<float> scores;
+    std::vector<uint32_t> touched;
+    std::string passageBuffer;
+    JsonDocument passageDoc;
+};
+
+// Persistent store of research passages (one per research iteration) with a
+// BM25-ranked inverted index.
+//
+// `<directory>/passages.log` is the source of truth: one passage per line,
+// "<crc32 hex> <compact JSON>\n", appended on add(). `<directory>/index.seg`
+// is an immutable index over a prefix of that log: passage table, term
+// dictionary sorted by (hash, term), postings and a string pool, in native
+// byte order. It is memory-mapped on open(), so startup cost does not grow
+// with the store. Passages past the segment's prefix are held in an
+// in-memory delta index; queries consult both.
+//
+// flush() merges segment and delta into a new segment (written aside and
+// renamed into place). add() flushes automatically once the delta reaches
+// half the segment's size (and at least flushEveryPassages), which keeps
+// the amortized cost of indexing a passage independent of the store size.
+// sync() and close() only make the log durable; open() re-indexes the log
+// tail past the segment, so ending a run never rewrites the segment.
+// An invalid segment is ignored and rebuilt from the log.
+//
+// The const search() overload only reads the index and the log, so any
+// number of threads may call it concurrently (each with its own scratch)
+// while nothing calls add(), flush() or close().
+class KnowledgeBase {
+public:
+    explicit KnowledgeBase(KnowledgeBaseOptions knowledgeOptions = KnowledgeBaseOptions())
+        : options(std::move(knowledgeOptions)),
+          logPath(options.directory + "/passages.log"),
+          segmentPath(options.directory + "/index.seg") {}
+
+    ~KnowledgeBase() { close(); }
+
+    KnowledgeBase(const KnowledgeBase&) = delete;
+    KnowledgeBase& operator=(const KnowledgeBase&) = delete;
+
+    // Maps the segment and indexes any log tail it does not cover.
+    bool open() {
+        ::mkdir(options.directory.c_str(), 0755);
+        logFd = ::open(logPath.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (logFd < 0) {
+            std::cerr << "Error: Could not open knowledge base log '" << logPath << "'." << std::endl;
+            return false;
+        }
+        struct stat info;
+        if (::fstat(logFd, &info) != 0) {
+            close();
+            return false;
+        }
+        logBytes = static_cast<uint64_t>(info.st_size);
+        uint64_t indexedBytes = mapSegment() ? segmentHeader->logBytes : 0;
+        indexLog(indexedBytes);
+        return true;
+    }
+
+    // Appends a passage to the log and indexes it.
+    bool add(int iteration, std::string_view topic, std::string_view text) {
+        if (logFd < 0) return false;
+        line.clear();
+        line.append(9, ' ');
+        JsonWriter writer(line, false);
+        writer.beginObject();
+        writer.member("iteration", iteration);
+        writer.member("topic", topic);
+        writer.member("text", text);
+        writer.endObject();
+        char checksum[9];
+        std::snprintf(checksum, sizeof(checksum), "%08x", crc32(std::string_view(line).substr(9)));
+        line.replace(0, 8, checksum, 8);
+        line.push_back('\n');
+        if (!writeAll(logFd, line)) {
+            std::cerr << "Error: Could not append to knowledge base log '" << logPath << "'." << std::endl;
+            return false;
+        }
+        indexPassage(logBytes + 9, static_cast<uint32_t>(line.size() - 10), text);
+        logBytes += line.size();
+        if (deltaPassages.size() >= std::max(options.flushEveryPassages, static_cast<size_t>(segmentPassageCount() / 2))) flush();
+        return true;
+    }
+
+    // Fills `hits` with up to `k` passages ranked by BM25 against `query`,
+    // best first. Passages with identical topic and text (e.g. from a resumed
+    // run) are reported once. Returns hits.size().
+    size_t search(std::string_view query, size_t k, std::vector<KnowledgeHit>& hits) { return search(query, k, hits, scratch); }
+
+    size_t search(std::string_view query, size_t k, std::vector<KnowledgeHit>& hits, KnowledgeSearchScratch& work) const {
+        std::vector<std::string>& queryTerms = work.queryTerms;
+        std::vector<float>& scores = work.scores;
+        std::vector<uint32_t>& touched = work.touched;
+        hits.clear();
+        size_t total = size();
+        if (total == 0 || k == 0) return 0;
+        uint64_t tokens = (segmentHeader ? segmentHeader->totalTokens : 0) + deltaTokens;
+        double averageLength = tokens > 0 ? static_cast<double>(tokens) / static_cast<double>(total) : 1.0;
+
+        queryTerms.clear();
+        forEachToken(query, [&](std::string_view token) {
+            if (std::find(queryTerms.begin(), queryTerms.end(), token) == queryTerms.end()) queryTerms.emplace_back(token);
+        });
+        if (scores.size() < total) scores.resize(total, 0.0f);
+        touched.clear();
+
+        constexpr double k1 = 1.2;
+        constexpr double b = 0.75;
+        for (const std::string& term : queryTerms) {
+            const Posting* basePostings = nullptr;
+            size_t baseCount = 0;
+            findSegmentTerm(term, basePostings, baseCount);
+            auto delta = deltaTerms.find(term);
+            size_t deltaCount = delta == deltaTerms.end() ? 0 : delta->second.size();
+            double documentFrequency = static_cast<double>(baseCount + deltaCount);
+            if (documentFrequency == 0.0) continue;
+            double idf = std::log(1.0 + (static_cast<double>(total) - documentFrequency + 0.5) / (documentFrequency + 0.5));
+            auto accumulate = [&](const Posting& posting) {
+                double frequency = posting.frequency;
+                double length = passageAt(posting.passage).tokens;
+                float& score = scores[posting.passage];
+                if (score == 0.0f) touched.push_back(posting.passage);
+                score += static_cast<float>(idf * frequency * (k1 + 1.0) / (frequency + k1 * (1.0 - b + b * length / averageLength)));
+            };
+            for (size_t i = 0; i < baseCount; ++i) accumulate(basePostings[i]);
+            for (size_t i = 0; i < deltaCount; ++i) accumulate(delta->second[i]);
+        }
+
+        // Newer passages win ties.
+        auto better = [&](uint32_t x, uint32_t y) { return scores[x] != scores[y] ? scores[x] > scores[y] : x > y; };
+        size_t ranked = 0;
+        size_t considered = 0;
+        while (hits.size() < k && considered < touched.size()) {
+            size_t want = std::min(touched.size(), std::max(ranked * 2, k + 8));
+            if (want > ranked) {
+                std::partial_sort(touched.begin() + static_cast<std::ptrdiff_t>(ranked), touched.begin() + static_cast<std::ptrdiff_t>(want), touched.end(), better);
+                ranked = want;
+            }
+            for (; considered < ranked && hits.size() < k; ++considered) {
+                KnowledgeHit hit;
+                if (!readPassage(touched[considered], hit, work)) continue;
+                bool duplicate = std::any_of(hits.begin(), hits.end(), [&](const KnowledgeHit& seen) { return seen.topic == hit.topic && seen.text == hit.text; });
+                if (duplicate) continue;
+                hit.score = scores[touched[considered]];
+                hits.push_back(std::move(hit));
+            }
+        }
+        for (uint32_t passage : touched) scores[passage] = 0.0f;
+        return hits.size();
+    }
+
+    // Writes segment + delta as the new segment and maps it.
+    bool flush() {
+        if (logFd < 0 || deltaPassages.empty()) return true;
+        if (::fdatasync(logFd) != 0) {
+            std::cerr << "Error: Could not sync knowledge base log '" << logPath << "'." << std::endl;
+            return false;
+        }
+        if (!writeSegment()) {
+            std::cerr << "Error: Could not write knowledge index '" << segmentPath << "'." << std::endl;
+            return false;
+        }
+        unmapSegment();
+        clearDelta();
+        if (!mapSegment()) indexLog(0);
+        return true;
+    }
+
+    // Makes appended passages durable without touching the segment.
+    bool sync() {
+        if (logFd < 0) return true;
+        if (::fdatasync(logFd) != 0) {
+            std::cerr << "Error: Could not sync knowledge base log '" << logPath << "'." << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (logFd < 0) return;
+        sync();
+        unmapSegment();
+        clearDelta();
+        ::close(logFd);
+        logFd = -1;
+    }
+
+    size_t size() const { return segmentPassageCount() + deltaPassages.size(); }
+    size_t pendingPassages() const { return deltaPassages.size(); }
+    const std::string& directory() const { return options.directory; }
+
+private:
+    struct SegmentHeader {
+        char magic[8];
+        uint64_t passageCount;
+        uint64_t termCount;
+        uint64_t postingCount;
+        uint64_t stringBytes;
+        uint64_t totalTokens;
+        uint64_t logBytes; // prefix of passages.log covered by this segment
+    };
+
+    struct PassageEntry {
+        uint64_t logOffset; // start of the passage's JSON in passages.log
+        uint32_t logLength;
+        uint32_t tokens;
+    };
+
+    struct TermEntry {
+        uint64_t hash;
+        uint64_t postingsStart;
+        uint64_t stringOffset;
+        uint32_t documentFrequency;
+        uint32_t stringLength;
+    };
+
+    struct Posting {
+        uint32_t passage;
+        uint32_t frequency;
+    };
+
+    static constexpr char kSegmentMagic[8] = {'D', 'R', 'K', 'B', 'I', 'D', 'X', '1'};
+
+    size_t segmentPassageCount() const { return segmentHeader ? static_cast<size_t>(segmentHeader->passageCount) : 0; }
+
+    const PassageEntry& passageAt(uint32_t passage) const {
+        size_t base = segmentPassageCount();
+        return passage < base ? segmentPassages[passage] : deltaPassages[passage - base];
+    }
+
+    std::string_view segmentTerm(const TermEntry& entry) const {
+        return std::string_view(segmentStrings + entry.stringOffset, entry.stringLength);
+    }
+
+    void findSegmentTerm(std::string_view term, const Posting*& postings, size_t& count) const {
+        if (!segmentHeader) return;
+        uint64_t hash = fnv1a64(term);
+        const TermEntry* end = segmentTerms + segmentHeader->termCount;
+        const TermEntry* found = std::lower_bound(segmentTerms, end, hash, [](const TermEntry& entry, uint64_t value) { return entry.hash < value; });
+        for (; found != end && found->hash == hash; ++found) {
+            if (segmentTerm(*found) == term) {
+                postings = segmentPostings + found->postingsStart;
+                count = found->documentFrequency;
+                return;
+            }
+        }
+    }
+
+    void indexPassage(uint64_t logOffset, uint32_t logLength, std::string_view text) {
+        uint32_t passage = static_cast<uint32_t>(size());
+        uint32_t tokens = 0;
+        forEachToken(text, [&](std::string_view token) {
+            ++tokens;
+            termKey.assign(token);
+            std::vector<Posting>& postings = deltaTerms[termKey];
+            if (!postings.empty() && postings.back().passage == passage) {
+                ++postings.back().frequency;
+            } else {
+                postings.push_back(Posting{passage, 1});
+            }
+        });
+        deltaPassages.push_back(PassageEntry{logOffset, logLength, tokens});
+        deltaTokens += tokens;
+    }
+
+    // Indexes log records from `from` onwards into the delta; cuts off a torn
+    // or corrupt tail.
+    void indexLog(uint64_t from) {
+        if (from > logBytes) from = 0;
+        if (from == 0) {
+            unmapSegment();
+            clearDelta();
+        }
+        std::string tail(static_cast<size_t>(logBytes - from), '\0');
+        if (!readAt(logFd, from, tail)) {
+            std::cerr << "Error: Could not read knowledge base log '" << logPath << "'." << std::endl;
+            return;
+        }
+        JsonDocument doc;
+        size_t position = 0;
+        while (position < tail.size()) {
+            size_t newline = tail.find('\n', position);
+            if (newline == std::string::npos || newline - position < 10 || tail[position + 8] != ' ') break;
+            std::string_view body(tail.data() + position + 9, newline - position - 9);
+            uint32_t expected = 0;
+            auto parsed = std::from_chars(tail.data() + position, tail.data() + position + 8, expected, 16);
+            if (parsed.ec != std::errc() || expected != crc32(body) || !doc.parse(body)) break;
+            indexPassage(from + position + 9, static_cast<uint32_t>(body.size()), doc.root()["text"].asString());
+            position = newline + 1;
+        }
+        if (position < tail.size()) {
+            std::cerr << "Warning: Discarding " << (tail.size() - position) << " bytes of torn or corrupt knowledge base log tail." << std::endl;
+            logBytes = from + position;
+            if (::ftruncate(logFd, static_cast<off_t>(logBytes)) != 0) {
+                std::cerr << "Error: Could not truncate knowledge base log '" << logPath << "'." << std::endl;
+            }
+        }
+    }
+
+    bool readPassage(uint32_t passage, KnowledgeHit& hit, KnowledgeSearchScratch& work) const {
+        const PassageEntry& entry = passageAt(passage);
+        work.passageBuffer.resize(entry.logLength);
+        if (!readAt(logFd, entry.logOffset, work.passageBuffer) || !work.passageDoc.parse(work.passageBuffer)) return false;
+        JsonRef root = work.passageDoc.root();
+        hit.passage = passage;
+        hit.iteration = root["iteration"].asInt();
+        hit.topic.assign(root["topic"].asString());
+        hit.text.assign(root["text"].asString());
+        return true;
+    }
+
+    bool mapSegment() {
+        int fd = ::open(segmentPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        struct stat info;
+        if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SegmentHeader)) {
+            ::close(fd);
+            std::cerr << "Warning: Knowledge index '" << segmentPath << "' is truncated; rebuilding it from the passage log." << std::endl;
+            return false;
+        }
+        size_t bytes = static_cast<size_t>(info.st_size);
+        void* data = ::mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+
+        const SegmentHeader* header = static_cast<const SegmentHeader*>(data);
+        uint64_t expected = sizeof(SegmentHeader) + header->passageCount * sizeof(PassageEntry) + header->termCount * sizeof(TermEntry) +
+                            header->postingCount * sizeof(Posting) + header->stringBytes;
+        if (std::memcmp(header->magic, kSegmentMagic, sizeof(kSegmentMagic)) != 0 || expected != bytes || header->logBytes > logBytes) {
+            ::munmap(data, bytes);
+            std::cerr << "Warning: Knowledge index '" << segmentPath << "' does not match the passage log; rebuilding it." << std::endl;
+            return false;
+        }
+        ::madvise(data, bytes, MADV_RANDOM);
+        const char* cursor = static_cast<const char*>(data) + sizeof(SegmentHeader);
+        segmentPassages = reinterpret_cast<const PassageEntry*>(cursor);
+        cursor += header->passageCount * sizeof(PassageEntry);
+        segmentTerms = reinterpret_cast<const TermEntry*>(cursor);
+        cursor += header->termCount * sizeof(TermEntry);
+        segmentPostings = reinterpret_cast<const Posting*>(cursor);
+        cursor += header->postingCount * sizeof(Posting);
+        segmentStrings = cursor;
+        segmentHeader = header;
+        segmentBytes = bytes;
+        return true;
+    }
+
+    void unmapSegment() {
+        if (!segmentHeader) return;
+        ::munmap(const_cast<SegmentHeader*>(segmentHeader), segmentBytes);
+        segmentHeader = nullptr;
+        segmentPassages = nullptr;
+        segmentTerms = nullptr;
+        segmentPostings = nullptr;
+        segmentStrings = nullptr;
+        segmentBytes = 0;
+    }
+
+    void clearDelta() {
+        deltaTerms.clear();
+        deltaPassages.clear();
+        deltaTokens = 0;
+    }
+
+    struct DeltaTerm {
+        uint64_t hash;
+        const std::string* term;
+        const std::vector<Posting>* postings;
+    };
+
+    // Walks the union of segment and delta terms in (hash, term) order:
+    // fn(hash, term, segment postings, segment count, delta postings or null).
+    template <typename Fn>
+    void forEachMergedTerm(const std::vector<DeltaTerm>& delta, Fn&& fn) const {
+        size_t baseTerms = segmentHeader ? static_cast<size_t>(segmentHeader->termCount) : 0;
+        size_t i = 0;
+        size_t j = 0;
+        while (i < baseTerms || j < delta.size()) {
+            int order = 0;
+            if (i == baseTerms) {
+                order = 1;
+            } else if (j == delta.size()) {
+                order = -1;
+            } else if (segmentTerms[i].hash != delta[j].hash) {
+                order = segmentTerms[i].hash < delta[j].hash ? -1 : 1;
+            } else {
+                order = segmentTerm(segmentTerms[i]).compare(*delta[j].term);
+            }
+            if (order < 0) {
+                const TermEntry& entry = segmentTerms[i++];
+                fn(entry.hash, segmentTerm(entry), segmentPostings + entry.postingsStart, static_cast<size_t>(entry.documentFrequency), nullptr);
+            } else if (order > 0) {
+                const DeltaTerm& entry = delta[j++];
+                fn(entry.hash, std::string_view(*entry.term), nullptr, size_t{0}, entry.postings);
+            } else {
+                const TermEntry& entry = segmentTerms[i++];
+                fn(entry.hash, segmentTerm(entry), segmentPostings + entry.postingsStart, static_cast<size_t>(entry.documentFrequency), delta[j++].postings);
+            }
+        }
+    }
+
+    bool writeSegment() {
+        std::vector<DeltaTerm> delta;
+        delta.reserve(deltaTerms.size());
+        for (const auto& term : deltaTerms) delta.push_back(DeltaTerm{fnv1a64(term.first), &term.first, &term.second});
+        std::sort(delta.begin(), delta.end(), [](const DeltaTerm& a, const DeltaTerm& b) { return a.hash != b.hash ? a.hash < b.hash : *a.term < *b.term; });
+
+        SegmentHeader header{};
+        std::memcpy(header.magic, kSegmentMagic, sizeof(kSegmentMagic));
+        header.passageCount = size();
+        header.totalTokens = (segmentHeader ? segmentHeader->totalTokens : 0) + deltaTokens;
+        header.logBytes = logBytes;
+        forEachMergedTerm(delta, [&](uint64_t, std::string_view term, const Posting*, size_t baseCount, const std::vector<Posting>* extra) {
+            ++header.termCount;
+            header.postingCount += baseCount + (extra ? extra->size() : 0);
+            header.stringBytes += term.size();
+        });
+
+        std::string temp = segmentPath + ".tmp";
+        int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+        std::string buffer;
+        bool ok = true;
+        auto put = [&](const void* data, size_t bytes) {
+            buffer.append(static_cast<const char*>(data), bytes);
+            if (buffer.size() >= (1u << 20)) {
+                ok = ok && writeAll(fd, buffer);
+                buffer.clear();
+            }
+        };
+
+        put(&header, sizeof(header));
+        for (size_t i = 0; i < segmentPassageCount(); ++i) put(&segmentPassages[i], sizeof(PassageEntry));
+        for (const PassageEntry& entry : deltaPassages) put(&entry, sizeof(PassageEntry));
+        uint64_t postingsStart = 0;
+        uint64_t stringOffset = 0;
+        forEachMergedTerm(delta, [&](uint64_t hash, std::string_view term, const Posting*, size_t baseCount, const std::vector<Posting>* extra) {
+            size_t count = baseCount + (extra ? extra->size() : 0);
+            TermEntry entry{hash, postingsStart, stringOffset, static_cast<uint32_t>(count), static_cast<uint32_t>(term.size())};
+            put(&entry, sizeof(entry));
+            postingsStart += count;
+            stringOffset += term.size();
+        });
+        // Delta passage ids all follow segment ids, so postings stay sorted.
+        forEachMergedTerm(delta, [&](uint64_t, std::string_view, const Posting* base, size_t baseCount, const std::vector<Posting>* extra) {
+            if (baseCount > 0) put(base, baseCount * sizeof(Posting));
+            if (extra && !extra->empty()) put(extra->data(), extra->size() * sizeof(Posting));
+        });
+        forEachMergedTerm(delta, [&](uint64_t, std::string_view term, const Posting*, size_t, const std::vector<Posting>*) {
+            put(term.data(), term.size());
+        });
+        ok = ok && writeAll(fd, buffer);
+
+        bool synced = ok && ::fdatasync(fd) == 0;
+        bool closed = ::close(fd) == 0;
+        if (!synced || !closed || std::rename(temp.c_str(), segmentPath.c_str()) != 0) {
+            ::unlink(temp.c_str());
+            return false;
+        }
+        syncParentDirectory(segmentPath);
+        return true;
+    }
+
+    static bool readAt(int fd, uint64_t offset, std::string& out) {
+        size_t done = 0;
+        while (done < out.size()) {
+            ssize_t got = ::pread(fd, &out[done], out.size() - done, static_cast<off_t>(offset + done));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            done += static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    static bool writeAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+        return true;
+    }
+
+    KnowledgeBaseOptions options;
+    std::string logPath;
+    std::string segmentPath;
+    int logFd = -1;
+    uint64_t logBytes = 0;
+
+    const SegmentHeader* segmentHeader = nullptr;
+    const PassageEntry* segmentPassages = nullptr;
+    const TermEntry* segmentTerms = nullptr;
+    const Posting* segmentPostings = nullptr;
+    const char* segmentStrings = nullptr;
+    size_t segmentBytes = 0;
+
+    std::unordered_map<std::string, std::vector<Posting>> deltaTerms;
+    std::vector<PassageEntry> deltaPassages;
+    uint64_t deltaTokens = 0;
+
+    // Scratch reused across calls.
+    std::string line;
+    std::string termKey;
+    KnowledgeSearchScratch scratch;
+};
@@ -0,0 +1,387 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "json.h"
+
+enum class LogLevel {
+    DEBUG,
+    INFO,
+    NOTICE,  // results the user asked for (final summary, answers); shown in quiet mode
+    WARNING, // WARNING and ERROR go to stderr
+    ERROR
+};
+
+inline const char* logLevelToString(LogLevel level) {
+    switch (level) {
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO: return "INFO";
+        case LogLevel::NOTICE: return "NOTICE";
+        case LogLevel::WARNING: return "WARNING";
+        case LogLevel::ERROR: return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+struct LoggerOptions {
+    LogLevel consoleLevel = LogLevel::INFO; // quiet mode raises this to NOTICE
+    std::string jsonPath;                   // JSON-lines sink; empty disables it
+    size_t capacity = 4096;                 // ring buffer slots, rounded up to a power of two
+};
+
+class Logger;
+
+// One log record, built with << and submitted when it goes out of scope.
+// Records below every sink's threshold are never formatted.
+class LogLine {
+public:
+    LogLine(Logger* target, LogLevel recordLevel, bool endWithNewline);
+    LogLine(LogLine&& other) noexcept
+        : logger(other.logger), level(other.level), endLine(other.endLine), text(std::move(other.text)) {
+        other.logger = nullptr;
+    }
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+    ~LogLine();
+
+    LogLine& operator<<(std::string_view value) {
+        if (logger) text.append(value);
+        return *this;
+    }
+    LogLine& operator<<(const char* value) { return *this << std::string_view(value); }
+    LogLine& operator<<(const std::string& value) { return *this << std::string_view(value); }
+    LogLine& operator<<(char value) {
+        if (logger) text.push_back(value);
+        return *this;
+    }
+    LogLine& operator<<(double value) {
+        if (logger) {
+            // Same rendering as std::ostream's default (%g, precision 6).
+            char buffer[32];
+            int length = std::snprintf(buffer, sizeof(buffer), "%g", value);
+            text.append(buffer, static_cast<size_t>(length));
+        }
+        return *this;
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value, int>::type = 0>
+    LogLine& operator<<(T value) {
+        if (logger) {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            text.append(buffer, static_cast<size_t>(result.ptr - buffer));
+        }
+        return *this;
+    }
+
+private:
+    Logger* logger;
+    LogLevel level;
+    bool endLine;
+    std::string text;
+};
+
+// Asynchronous logger. Producers format into a reusable string and publish
+// it into a bounded lock-free ring (Vyukov's sequence-numbered slots, so any
+// thread may log); a background thread drains the ring in batches and issues
+// one write() per batch and stream instead of flushing every line.
+//
+// Console records go to stdout, WARNING and above to stderr, in submission
+// order. The optional JSON-lines sink receives every record with its level,
+// timestamp and the calling thread's iteration/phase context. When the thread
+// has a session bound (daemon mode), console lines are prefixed with
+// "[session] " and JSON records carry a "session" member.
+//
+// A full ring makes producers wait rather than drop records. flush() blocks
+// until everything logged so far has been written; the destructor drains the
+// ring before returning.
+class Logger {
+public:
+    explicit Logger(LoggerOptions loggerOptions = LoggerOptions()) : options(std::move(loggerOptions)) {
+        size_t capacity = 2;
+        while (capacity < options.capacity) capacity <<= 1;
+        mask = capacity - 1;
+        slots.reset(new Slot[capacity]);
+        for (size_t i = 0; i < capacity; ++i) slots[i].sequence.store(i, std::memory_order_relaxed);
+        if (!options.jsonPath.empty()) {
+            jsonFd = ::open(options.jsonPath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            if (jsonFd < 0) std::cerr << "Warning: Could not open log file '" << options.jsonPath << "'; structured logging disabled." << std::endl;
+        }
+        writer = std::thread([this] { drainLoop(); });
+    }
+
+    ~Logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (writer.joinable()) writer.join();
+        if (jsonFd >= 0) {
+            ::fdatasync(jsonFd);
+            ::close(jsonFd);
+        }
+    }
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    LogLine debug() { return LogLine(this, LogLevel::DEBUG, true); }
+    LogLine info() { return LogLine(this, LogLevel::INFO, true); }
+    LogLine notice() { return LogLine(this, LogLevel::NOTICE, true); }
+    LogLine warning() { return LogLine(this, LogLevel::WARNING, true); }
+    LogLine error() { return LogLine(this, LogLevel::ERROR, true); }
+
+    // Writes `text` without a trailing newline and waits until it is visible,
+    // for prompts that precede reading stdin.
+    void prompt(std::string_view text) {
+        LogLine(this, LogLevel::NOTICE, false) << text;
+        flush();
+    }
+
+    bool enabled(LogLevel level) const { return level >= options.consoleLevel || jsonFd >= 0; }
+
+    // Blocks until every record submitted before the call has been written.
+    // `durable` additionally syncs the JSON sink to disk.
+    void flush(bool durable = false) {
+        size_t target = enqueuePosition.load(std::memory_order_acquire);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            flushRequested = true;
+            wake.notify_one();
+            flushed.wait(lock, [&] { return writtenPosition >= target || stopped; });
+        }
+        if (durable && jsonFd >= 0) ::fdatasync(jsonFd);
+    }
+
+    // Iteration and phase reported with this thread's subsequent records.
+    static void setContext(int iteration, const char* phase) {
+        context().iteration = iteration;
+        context().phase = phase;
+    }
+
+    // Session reported with this thread's subsequent records (nullptr for
+    // none). The string must outlive every record logged under it.
+    static void setSession(const char* session) { context().session = session; }
+
+    // Times a producer found the ring full and had to wait.
+    uint64_t stalls() const { return producerStalls.load(std::memory_order_relaxed); }
+
+private:
+    friend class LogLine;
+
+    struct Context {
+        int iteration = -1;
+        const char* phase = nullptr;
+        const char* session = nullptr;
+    };
+
+    struct Record {
+        LogLevel level = LogLevel::INFO;
+        bool endLine = true;
+        int iteration = -1;
+        const char* phase = nullptr;
+        const char* session = nullptr;
+        int64_t timeUs = 0;
+        std::string text;
+    };
+
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        Record record;
+    };
+
+    static Context& context() {
+        thread_local Context current;
+        return current;
+    }
+
+    // Strings cycle between producers and slots so steady-state logging
+    // does not allocate.
+    static std::string& spareText() {
+        thread_local std::string spare;
+        return spare;
+    }
+
+    void submit(LogLevel level, bool endLine, std::string& text) {
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[position & mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (difference < 0) {
+                producerStalls.fetch_add(1, std::memory_order_relaxed);
+                wakeWriter();
+                std::this_thread::yield();
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        Record& record = slot->record;
+        record.level = level;
+        record.endLine = endLine;
+        record.iteration = context().iteration;
+        record.phase = context().phase;
+        record.session = context().session;
+        record.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        record.text.swap(text);
+        slot->sequence.store(position + 1, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (writerIdle.load(std::memory_order_relaxed)) wakeWriter();
+    }
+
+    void wakeWriter() {
+        std::lock_guard<std::mutex> lock(mutex);
+        wake.notify_one();
+    }
+
+    bool pending() const {
+        return slots[dequeuePosition & mask].sequence.load(std::memory_order_acquire) == dequeuePosition + 1;
+    }
+
+    void drainLoop() {
+        Record record;
+        for (;;) {
+            while (pending()) {
+                Slot& slot = slots[dequeuePosition & mask];
+                record.text.swap(slot.record.text);
+                record.level = slot.record.level;
+                record.endLine = slot.record.endLine;
+                record.iteration = slot.record.iteration;
+                record.phase = slot.record.phase;
+                record.session = slot.record.session;
+                record.timeUs = slot.record.timeUs;
+                slot.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+                ++dequeuePosition;
+                format(record);
+            }
+            writeConsole();
+            writeJson();
+
+            std::unique_lock<std::mutex> lock(mutex);
+            writtenPosition = dequeuePosition;
+            flushRequested = false;
+            flushed.notify_all();
+            if (stopping && !pending()) break;
+            writerIdle.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (!pending()) wake.wait_for(lock, std::chrono::milliseconds(100), [&] { return stopping || flushRequested || pending(); });
+            writerIdle.store(false, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        stopped = true;
+        flushed.notify_all();
+    }
+
+    void format(const Record& record) {
+        if (record.level >= options.consoleLevel) {
+            int fd = record.level >= LogLevel::WARNING ? STDERR_FILENO : STDOUT_FILENO;
+            // Keep stdout and stderr lines in submission order.
+            if (fd != consoleFd) writeConsole();
+            consoleFd = fd;
+            if (record.session) {
+                // Leading blank lines stay above the prefix.
+                size_t text = record.text.find_first_not_of('\n');
+                if (text == std::string::npos) text = record.text.size();
+                consoleBuffer.append(record.text, 0, text);
+                consoleBuffer.append("[").append(record.session).append("] ");
+                consoleBuffer.append(record.text, text, std::string::npos);
+            } else {
+                consoleBuffer.append(record.text);
+            }
+            if (record.endLine) consoleBuffer.push_back('\n');
+            if (consoleBuffer.size() >= kBatchBytes) writeConsole();
+        }
+        if (jsonFd >= 0) {
+            JsonWriter json(jsonBuffer, false);
+            json.beginObject();
+            json.member("timeUs", record.timeUs);
+            json.member("level", logLevelToString(record.level));
+            if (record.iteration >= 0) json.member("iteration", record.iteration);
+            if (record.phase) json.member("phase", record.phase);
+            if (record.session) json.member("session", record.session);
+            json.member("message", record.text);
+            json.endObject();
+            jsonBuffer.push_back('\n');
+            if (jsonBuffer.size() >= kBatchBytes) writeJson();
+        }
+    }
+
+    void writeConsole() {
+        writeAll(consoleFd, consoleBuffer);
+        consoleBuffer.clear();
+    }
+
+    void writeJson() {
+        if (jsonFd >= 0) writeAll(jsonFd, jsonBuffer);
+        jsonBuffer.clear();
+    }
+
+    static void writeAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return;
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+
+    static constexpr size_t kBatchBytes = 64 * 1024;
+
+    LoggerOptions options;
+    std::unique_ptr<Slot[]> slots;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePosition{0};
+    alignas(64) size_t dequeuePosition = 0; // writer thread only
+    std::atomic<bool> writerIdle{false};
+    std::atomic<uint64_t> producerStalls{0};
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    size_t writtenPosition = 0;
+    bool flushRequested = false;
+    bool stopping = false;
+    bool stopped = false;
+
+    int jsonFd = -1;
+    int consoleFd = STDOUT_FILENO;
+    std::string consoleBuffer;
+    std::string jsonBuffer;
+    std::thread writer;
+};
+
+inline LogLine::LogLine(Logger* target, LogLevel recordLevel, bool endWithNewline)
+    : logger(target && target->enabled(recordLevel) ? target : nullptr), level(recordLevel), endLine(endWithNewline) {
+    if (logger) {
+        text.swap(Logger::spareText());
+        text.clear();
+    }
+}
+
+inline LogLine::~LogLine() {
+    if (!logger) return;
+    logger->submit(level, endLine, text);
+    Logger::spareText().swap(text);
+}
@@ -10,418 +10,468 @@
 #include <limits>
 #include <algorithm>
 #include <random>
+#include <memory>
+#include <string_view>
+#include <csignal>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "debug_scanner.h"
+#include "json.h"
+#include "knowledge_base.h"
+#include "logger.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "phase_simulator.h"
+#include "program_config.h"
+#include "qa_server.h"
+#include "research_daemon.h"
+#include "research_session.h"
+#include "research_topic.h"
+#include "researcher_worker.h"
+#include "result_cache.h"
+#include "state_journal.h"
+#include "subprocess.h"
+#include "validation_runner.h"
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--researcher <path>] [--persistent-researcher] [--researcher-timeout <s>]\n"
+              << "       [--no-cache] [--cache-dir <dir>] [--cache-memory-mb <n>] [--cache-disk-mb <n>]\n"
+              << "       [--knowledge-dir <dir>] [--answer-passages <k>]\n"
+              << "       [--pacing <mode>] [--inspect-iteration <n>] [--resume-from <n>] [--quiet] [--log-json <path>]\n"
+              << "       [--metrics-file <path>] [--metrics-interval <s>] [--seed <n>]\n"
+              << "       [--daemon <dir>] [--workers <n>] [--max-researchers <n>]\n"
+              << "       [--serve <socket>] [--serve-workers <n>] [--answer-batch <file>]\n"
+              << "       [--fanout <n>] [--fanout-workers <n>] [--scan-root <dir>] [--scan-threads <n>] [--no-debug-scan]\n"
+              << "       [--validation-manifest <path>] [--validation-threads <n>]\n"
+              << "       [--simulate <runs>] [--simulate-threads <n>] [--simulate-max-iterations <n>] [--sweep <name>=<from>[:<to>:<step>]]\n"
+              << "  --researcher <path>        researcher executable (default ./rust_researcher)\n"
+              << "  --persistent-researcher    keep one researcher process alive (--serve framing protocol)\n"
+              << "  --no-cache                 always invoke the researcher, ignoring cached results\n"
+              << "  --cache-dir <dir>          researcher result cache location (default .research_cache)\n"
+              << "  --cache-memory-mb <n>      in-memory LRU budget (default 16)\n"
+              << "  --cache-disk-mb <n>        on-disk cache budget (default 256)\n"
+              << "  --knowledge-dir <dir>      persistent research knowledge base (default .knowledge)\n"
+              << "  --answer-passages <k>      passages retrieved per question (default 3)\n"
+              << "  --pacing <mode>            realtime (default), virtual (no sleeping) or a speedup such as 100x\n"
+              << "  --quiet                    only print results, answers, warnings and errors\n"
+              << "  --log-json <path>          also append every log record as a JSON line to <path>\n"
+              << "  --metrics-file <path>      Prometheus text export, rewritten periodically (default metrics.prom, '' = off)\n"
+              << "  --metrics-interval <s>     seconds between metrics exports (default 5, 0 = only at exit)\n"
+              << "  --seed <n>                 seed the simulated outcomes for a reproducible run\n"
+              << "  --daemon <dir>             drive every session directory under <dir> concurrently, then exit\n"
+              << "  --workers <n>              daemon worker threads (default 4)\n"
+              << "  --max-researchers <n>      daemon researcher processes running at once (default 8)\n"
+              << "  --serve <socket>           once research concludes, answer questions on a Unix socket until SIGINT/SIGTERM\n"
+              << "  --serve-workers <n>        question answering threads (default: one per CPU)\n"
+              << "  --answer-batch <file>      once research concludes, answer each line of <file> ('-' = stdin) as JSON on stdout\n"
+              << "  --fanout <n>               split each research cycle into n subtopics researched concurrently (default 1)\n"
+              << "  --fanout-workers <n>       researcher calls running at once in a fanned-out cycle (default n)\n"
+              << "  --scan-root <dir>          DEBUGGING tails *.log files under <dir> and searches <dir>/src for the error (default .)\n"
+              << "  --scan-threads <n>         threads reading changed files for that scan (default: one per CPU)\n"
+              << "  --no-debug-scan            only narrate the find/grep commands in DEBUGGING\n"
+              << "  --validation-manifest <path>  test units VALIDATION_TESTS runs, if the file exists (default validation.json)\n"
+              << "  --validation-threads <n>   test units running at once (default: one per CPU)\n"
+              << "  --simulate <runs>          simulate <runs> trajectories of the phase state machine (no I/O or sleeping), report and exit\n"
+              << "  --simulate-threads <n>     simulation threads (default: one per CPU)\n"
+              << "  --simulate-max-iterations <n>  count a trajectory as unfinished after n iterations (default 10000)\n"
+              << "  --sweep <name>=<range>     vary a simulation parameter over <from>[:<to>:<step>]; repeat for a grid. Names:\n"
+              << "                             llm-chance, llm-after, validation-pass-rate, forced-pass-after, stall-after,\n"
+              << "                             complete-score, error-rate, score-gain\n"
+              << "  --researcher-timeout <s>   kill a researcher call after this many seconds (default 120, 0 = never)\n"
+              << "  --inspect-iteration <n>    print the journaled state as of iteration n and exit\n"
+              << "  --resume-from <n>          rewind to the journaled state of iteration n and continue from there" << std::endl;
+}
 
-enum class ProgramPhase {
-    INITIAL_SETUP,
-    RESEARCH_CYCLE,
-    LLM_INTEGRATION,
-    DEBUGGING,
-    VALIDATION_TESTS,
-    FINAL_ANALYSIS,
-    QUESTION_ANSWERING,
-    COMPLETE,
-    STALLED_UNRECOVERABLE
-};
-
-std::map<std::string, std::string> parseJson(const std::string& jsonString);
-std::string toJsonString(const std::map<std::string, std::string>& data);
-
-struct ProgramConfig {
-    std::string researchTopic;
-    int researchIteration;
-    bool researchComplete;
-    std::string lastResearchSummary;
-    std::string lastErrorMessage;
-    bool llama3SimulatedDownloaded;
-    ProgramPhase currentPhase;
-    int debugAttempts;
-    double researchCompletenessScore;
-
-    ProgramConfig() : researchTopic("general_knowledge"), researchIteration(0),
-                      researchComplete(false), lastResearchSummary("No research done yet."),
-                      lastErrorMessage("None"), llama3SimulatedDownloaded(false),
-                      currentPhase(ProgramPhase::INITIAL_SETUP), debugAttempts(0),
-                      researchCompletenessScore(0.0) {}
-
-    bool load(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Warning: Configuration file '" << filename << "' not found. Using default settings." << std::endl;
+bool parseOptions(int argc, char* argv[], OrchestratorOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--researcher" && i + 1 < argc) {
+            options.researcherPath = argv[++i];
+        } else if (arg == "--persistent-researcher") {
+            options.persistentResearcher = true;
+        } else if (arg == "--researcher-timeout" && i + 1 < argc) {
+            options.researcherTimeout = std::chrono::milliseconds(static_cast<long long>(std::strtod(argv[++i], nullptr) * 1000.0));
+        } else if (arg == "--no-cache") {
+            options.cacheResults = false;
+        } else if (arg == "--cache-dir" && i + 1 < argc) {
+            options.cache.directory = argv[++i];
+        } else if (arg == "--cache-memory-mb" && i + 1 < argc) {
+            options.cache.maxMemoryBytes = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (arg == "--cache-disk-mb" && i + 1 < argc) {
+            options.cache.maxDiskBytes = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (arg == "--knowledge-dir" && i + 1 < argc) {
+            options.knowledge.directory = argv[++i];
+        } else if (arg == "--answer-passages" && i + 1 < argc) {
+            options.answerPassages = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--pacing" && i + 1 < argc) {
+            if (!Pacer::parse(argv[++i], options.pacer)) {
+                std::cerr << "Error: Unknown pacing mode '" << argv[i] << "'." << std::endl;
+                return false;
+            }
+        } else if (arg == "--quiet") {
+            options.logging.consoleLevel = LogLevel::NOTICE;
+        } else if (arg == "--log-json" && i + 1 < argc) {
+            options.logging.jsonPath = argv[++i];
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            options.metricsPath = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            options.metricsInterval = std::chrono::milliseconds(static_cast<long long>(std::strtod(argv[++i], nullptr) * 1000.0));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = std::strtoll(argv[++i], nullptr, 10);
+        } else if (arg == "--daemon" && i + 1 < argc) {
+            options.daemonDirectory = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.daemonWorkers = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--max-researchers" && i + 1 < argc) {
+            options.maxResearchers = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--serve" && i + 1 < argc) {
+            options.serveSocket = argv[++i];
+        } else if (arg == "--serve-workers" && i + 1 < argc) {
+            options.serveWorkers = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--answer-batch" && i + 1 < argc) {
+            options.answerBatchPath = argv[++i];
+        } else if (arg == "--fanout" && i + 1 < argc) {
+            options.fanout = std::max<size_t>(1, static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10)));
+        } else if (arg == "--fanout-workers" && i + 1 < argc) {
+            options.fanoutWorkers = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--scan-root" && i + 1 < argc) {
+            options.debugScanOptions.root = argv[++i];
+        } else if (arg == "--scan-threads" && i + 1 < argc) {
+            options.debugScanThreads = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--no-debug-scan") {
+            options.debugScan = false;
+        } else if (arg == "--validation-manifest" && i + 1 < argc) {
+            options.validationManifest = argv[++i];
+        } else if (arg == "--validation-threads" && i + 1 < argc) {
+            options.validationThreads = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--simulate" && i + 1 < argc) {
+            options.simulateRuns = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--simulate-threads" && i + 1 < argc) {
+            options.simulateThreads = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        } else if (arg == "--simulate-max-iterations" && i + 1 < argc) {
+            options.simulateMaxIterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--sweep" && i + 1 < argc) {
+            options.sweeps.push_back(argv[++i]);
+        } else if (arg == "--inspect-iteration" && i + 1 < argc) {
+            options.inspectIteration = std::atoi(argv[++i]);
+        } else if (arg == "--resume-from" && i + 1 < argc) {
+            options.resumeIteration = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Error: Unknown or incomplete option '" << arg << "'." << std::endl;
             return false;
         }
-        std::stringstream buffer;
-        buffer << file.rdbuf();
-        file.close();
-        std::map<std::string, std::string> data = parseJson(buffer.str());
-
-        if (data.count("researchTopic")) researchTopic = data["researchTopic"];
-        if (data.count("researchIteration")) researchIteration = std::stoi(data["researchIteration"]);
-        if (data.count("researchComplete")) researchComplete = (data["researchComplete"] == "true");
-        if (data.count("lastResearchSummary")) lastResearchSummary = data["lastResearchSummary"];
-        if (data.count("lastErrorMessage")) lastErrorMessage = data["lastErrorMessage"];
-        if (data.count("llama3SimulatedDownloaded")) llama3SimulatedDownloaded = (data["llama3SimulatedDownloaded"] == "true");
-        if (data.count("debugAttempts")) debugAttempts = std::stoi(data["debugAttempts"]);
-        if (data.count("researchCompletenessScore")) researchCompletenessScore = std::stod(data["researchCompletenessScore"]);
-
-        if (data.count("currentPhase")) {
-            std::string phaseStr = data["currentPhase"];
-            if (phaseStr == "INITIAL_SETUP") currentPhase = ProgramPhase::INITIAL_SETUP;
-            else if (phaseStr == "RESEARCH_CYCLE") currentPhase = ProgramPhase::RESEARCH_CYCLE;
-            else if (phaseStr == "LLM_INTEGRATION") currentPhase = ProgramPhase::LLM_INTEGRATION;
-            else if (phaseStr == "DEBUGGING") currentPhase = ProgramPhase::DEBUGGING;
-            else if (phaseStr == "VALIDATION_TESTS") currentPhase = ProgramPhase::VALIDATION_TESTS;
-            else if (phaseStr == "FINAL_ANALYSIS") currentPhase = ProgramPhase::FINAL_ANALYSIS;
-            else if (phaseStr == "QUESTION_ANSWERING") currentPhase = ProgramPhase::QUESTION_ANSWERING;
-            else if (phaseStr == "COMPLETE") currentPhase = ProgramPhase::COMPLETE;
-            else if (phaseStr == "STALLED_UNRECOVERABLE") currentPhase = ProgramPhase::STALLED_UNRECOVERABLE;
-        }
-        return true;
     }
+    return true;
+}
 
-    bool save(const std::string& filename) const {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Error: Could not open configuration file '" << filename << "' for writing." << std::endl;
-            return false;
+static QuestionServer* activeServer = nullptr;
+
+void stopServing(int) {
+    if (activeServer) activeServer->requestStop();
+}
+
+// Serves --answer-batch and then --serve in place of the interactive loop.
+int answerNonInteractively(const OrchestratorOptions& options, Logger& logger, const KnowledgeBase& knowledge, const ProgramConfig& config,
+                           OrchestratorMetrics& metrics) {
+    QuestionServerOptions serverOptions;
+    serverOptions.workers = options.serveWorkers > 0 ? options.serveWorkers : std::max(1u, std::thread::hardware_concurrency());
+    serverOptions.answerPassages = options.answerPassages;
+    QuestionServer server(knowledge, config, serverOptions, metrics);
+
+    if (!options.answerBatchPath.empty()) {
+        int input = options.answerBatchPath == "-" ? STDIN_FILENO : ::open(options.answerBatchPath.c_str(), O_RDONLY | O_CLOEXEC);
+        if (input < 0) {
+            logger.error() << "Error: Question batch '" << options.answerBatchPath << "' cannot be opened.";
+            return 1;
         }
-        std::map<std::string, std::string> data;
-        data["researchTopic"] = researchTopic;
-        data["researchIteration"] = std::to_string(researchIteration);
-        data["researchComplete"] = researchComplete ? "true" : "false";
-        data["lastResearchSummary"] = lastResearchSummary;
-        data["lastErrorMessage"] = lastErrorMessage;
-        data["llama3SimulatedDownloaded"] = llama3SimulatedDownloaded ? "true" : "false";
-        data["debugAttempts"] = std::to_string(debugAttempts);
-        data["researchCompletenessScore"] = std::to_string(researchCompletenessScore);
-
-        switch (currentPhase) {
-            case ProgramPhase::INITIAL_SETUP: data["currentPhase"] = "INITIAL_SETUP"; break;
-            case ProgramPhase::RESEARCH_CYCLE: data["currentPhase"] = "RESEARCH_CYCLE"; break;
-            case ProgramPhase::LLM_INTEGRATION: data["currentPhase"] = "LLM_INTEGRATION"; break;
-            case ProgramPhase::DEBUGGING: data["currentPhase"] = "DEBUGGING"; break;
-            case ProgramPhase::VALIDATION_TESTS: data["currentPhase"] = "VALIDATION_TESTS"; break;
-            case ProgramPhase::FINAL_ANALYSIS: data["currentPhase"] = "FINAL_ANALYSIS"; break;
-            case ProgramPhase::QUESTION_ANSWERING: data["currentPhase"] = "QUESTION_ANSWERING"; break;
-            case ProgramPhase::COMPLETE: data["currentPhase"] = "COMPLETE"; break;
-            case ProgramPhase::STALLED_UNRECOVERABLE: data["currentPhase"] = "STALLED_UNRECOVERABLE"; break;
+        // Answers go straight to stdout, so nothing logged may interleave.
+        logger.flush();
+        auto started = std::chrono::steady_clock::now();
+        long long answered = server.answerBatch(input, STDOUT_FILENO);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        if (input != STDIN_FILENO) ::close(input);
+        if (answered < 0) return 1;
+        logger.info() << "[ORCHESTRATOR]: Answered " << answered << " batch questions with " << serverOptions.workers << " workers in "
+                      << elapsed.count() / 1000.0 << "s.";
+    }
+
+    if (!options.serveSocket.empty()) {
+        if (!server.listen(options.serveSocket)) return 1;
+        activeServer = &server;
+        struct sigaction action{};
+        action.sa_handler = stopServing;
+        sigemptyset(&action.sa_mask);
+        ::sigaction(SIGINT, &action, nullptr);
+        ::sigaction(SIGTERM, &action, nullptr);
+        logger.notice() << "[ORCHESTRATOR]: Serving questions on '" << options.serveSocket << "' with " << serverOptions.workers
+                        << " workers, one question per line, one JSON answer per line. Send SIGINT or SIGTERM to stop.";
+        logger.flush();
+        bool healthy = server.serve();
+        activeServer = nullptr;
+        ::unlink(options.serveSocket.c_str());
+        logger.notice() << "[ORCHESTRATOR]: Question server stopped after " << metrics.questions.get() << " answers.";
+        if (!healthy) return 1;
+    }
+    return 0;
+}
+
+// --simulate: Monte Carlo runs of the phase state machine, one report line
+// per sweep point.
+int runSimulation(const OrchestratorOptions& options, Logger& logger, uint32_t seed) {
+    std::vector<SweepAxis> axes(options.sweeps.size());
+    for (size_t i = 0; i < axes.size(); ++i) {
+        if (!axes[i].parse(options.sweeps[i])) {
+            logger.error() << "Error: Invalid --sweep '" << options.sweeps[i] << "'; expected <name>=<from>[:<to>:<step>] with a known parameter name.";
+            return 2;
         }
+    }
+    SimulationParameters base;
+    base.rules = options.rules;
+    std::vector<SimulationParameters> points;
+    std::vector<std::string> labels;
+    expandSweep(axes, base, points, labels);
+
+    SimulationOptions simulation;
+    simulation.trajectories = options.simulateRuns;
+    simulation.seed = seed;
+    simulation.maxIterations = options.simulateMaxIterations;
+    PhaseSimulator simulator(options.simulateThreads > 0 ? options.simulateThreads : std::max(1u, std::thread::hardware_concurrency()));
+    logger.notice() << "[SIMULATOR]: " << simulation.trajectories << " trajectories per point, " << points.size() << " point(s), "
+                    << simulator.threads() << " threads, seed " << seed << ".";
+    for (size_t i = 0; i < points.size(); ++i) {
+        auto started = std::chrono::steady_clock::now();
+        SimulationReport report = simulator.run(points[i], simulation);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        double runs = static_cast<double>(std::max<uint64_t>(1, report.trajectories));
+        logger.notice() << "[SIMULATOR]: " << labels[i] << ": completed " << 100.0 * static_cast<double>(report.completed) / runs
+                        << "%, stalled " << 100.0 * report.stallProbability() << "%, unfinished " << 100.0 * static_cast<double>(report.unfinished) / runs
+                        << "%; iterations to completion mean " << report.meanIterations() << ", p50 " << report.iterationsPercentile(0.5)
+                        << ", p90 " << report.iterationsPercentile(0.9) << ", p99 " << report.iterationsPercentile(0.99)
+                        << ", max " << report.iterationsPercentile(1.0) << " (" << elapsed.count() / 1000.0 << "s)";
+    }
+    logger.flush();
+    return 0;
+}
 
-        file << toJsonString(data);
-        file.close();
-        return true;
+int main(int argc, char* argv[]) {
+    OrchestratorOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
     }
-};
-
-std::string execCommand(const char* cmd) {
-    std::string result = "";
-    FILE* pipe = popen(cmd, "r");
-    if (!pipe) {
-        std::cerr << "Error: popen() failed!" << std::endl;
-        return "";
+
+    Logger logger(options.logging);
+    MetricsRegistry metricsRegistry;
+    OrchestratorMetrics metrics(metricsRegistry);
+    std::random_device rd;
+
+    if (options.simulateRuns > 0) {
+        return runSimulation(options, logger, options.seed >= 0 ? static_cast<uint32_t>(options.seed) : rd());
     }
-    char buffer[128];
-    while (!feof(pipe)) {
-        if (fgets(buffer, 128, pipe) != nullptr) {
-            result += buffer;
+
+    if (!options.daemonDirectory.empty()) {
+        std::unique_ptr<ResultCache> resultCache;
+        if (options.cacheResults) {
+            resultCache = std::make_unique<ResultCache>(hashExecutable(options.researcherPath), options.cache);
+        }
+        ResearchDaemon daemon(options, logger, metricsRegistry, metrics, resultCache.get());
+        uint32_t baseSeed = options.seed >= 0 ? static_cast<uint32_t>(options.seed) : rd();
+        if (!daemon.addSessions(options.daemonDirectory, baseSeed)) return 1;
+        std::unique_ptr<MetricsExporter> metricsExporter;
+        if (!options.metricsPath.empty()) {
+            metricsExporter = std::make_unique<MetricsExporter>(metricsRegistry, options.metricsPath, options.metricsInterval);
         }
+        int stalled = daemon.run();
+        if (metricsExporter) metricsExporter->exportNow();
+        logger.flush(true);
+        return stalled > 0 ? 1 : 0;
     }
-    pclose(pipe);
-    return result;
-}
 
-std::map<std::string, std::string> parseJson(const std::string& jsonString) {
-    std::map<std::string, std::string> data;
-    std::string cleanString = jsonString;
-    cleanString.erase(std::remove(cleanString.begin(), cleanString.end(), '{'), cleanString.end());
-    cleanString.erase(std::remove(cleanString.begin(), cleanString.end(), '}'), cleanString.end());
-    cleanString.erase(std::remove(cleanString.begin(), cleanString.end(), '"'), cleanString.end());
-
-    std::stringstream ss(cleanString);
-    std::string segment;
-    while (std::getline(ss, segment, ',')) {
-        std::stringstream ssSegment(segment);
-        std::string key, value;
-        if (std::getline(ssSegment, key, ':')) {
-            if (std::getline(ssSegment, value)) {
-                key.erase(0, key.find_first_not_of(" \t\n\r\f\v"));
-                key.erase(key.find_last_not_of(" \t\n\r\f\v") + 1);
-                value.erase(0, value.find_first_not_of(" \t\n\r\f\v"));
-                value.erase(value.find_last_not_of(" \t\n\r\f\v") + 1);
-                data[key] = value;
-            }
+    ResearchSession session("", "", options, logger, metrics, options.seed >= 0 ? static_cast<uint32_t>(options.seed) : rd());
+    if (!session.openState()) {
+        logger.error() << "Error: State journal '" << session.journal().journalFile() << "' cannot be opened or read; refusing to run without persistence.";
+        logger.flush(true);
+        return 1;
+    }
+    ProgramConfig& config = session.config();
+    Pacer& pacer = session.pacer();
+    KnowledgeBase& knowledge = session.knowledge();
+
+    if (options.inspectIteration >= 0) {
+        ProgramConfig earlier;
+        if (!session.journal().stateAt(options.inspectIteration, earlier)) {
+            logger.error() << "Error: Iteration " << options.inspectIteration << " is not recorded in '" << session.journal().journalFile() << "'.";
+            return 1;
         }
+        std::string state;
+        earlier.toJson(state);
+        logger.notice() << state;
+        return 0;
+    }
+    if (options.resumeIteration >= 0) {
+        if (!session.rewindTo(options.resumeIteration)) {
+            logger.error() << "Error: Iteration " << options.resumeIteration << " is not recorded in '" << session.journal().journalFile() << "'.";
+            return 1;
+        }
+        logger.info() << "[ORCHESTRATOR]: Rewound to the recorded state of iteration " << options.resumeIteration << ".";
     }
-    return data;
-}
 
-std::string toJsonString(const std::map<std::string, std::string>& data) {
-    std::string json = "{\n";
-    bool first = true;
-    for (const auto& pair : data) {
-        if (!first) {
-            json += ",\n";
+    std::unique_ptr<ResearcherWorker> researcherWorker;
+    if (options.persistentResearcher) {
+        researcherWorker = std::make_unique<ResearcherWorker>(options.researcherPath);
+        session.useResearcherWorker(researcherWorker.get());
+    }
+    std::unique_ptr<ResultCache> resultCache;
+    if (options.cacheResults) {
+        resultCache = std::make_unique<ResultCache>(hashExecutable(options.researcherPath), options.cache);
+        session.useResultCache(resultCache.get());
+    }
+    std::unique_ptr<WorkStealingPool> fanOutPool;
+    if (options.fanout > 1) {
+        if (options.persistentResearcher) {
+            logger.warning() << "Warning: Fanned-out research cycles run one-shot researchers; --persistent-researcher is not used for them.";
         }
-        json += "    \"" + pair.first + "\": \"" + pair.second + "\"";
-        first = false;
+        fanOutPool = std::make_unique<WorkStealingPool>(std::min(options.fanout, options.fanoutWorkers > 0 ? options.fanoutWorkers : options.fanout));
+        session.useFanOut(fanOutPool.get());
     }
-    json += "\n}";
-    return json;
-}
-// Helper function to replace all occurrences of a substring
-std::string replaceAll(std::string str, const std::string& from, const std::string& to) {
-    size_t start_pos = 0;
-    while((start_pos = str.find(from, start_pos)) != std::string::npos) {
-        str.replace(start_pos, from.length(), to);
-        start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+    std::unique_ptr<WorkStealingPool> scanPool;
+    std::unique_ptr<DebugScanner> debugScanner;
+    if (options.debugScan) {
+        scanPool = std::make_unique<WorkStealingPool>(options.debugScanThreads > 0 ? options.debugScanThreads : std::max(1u, std::thread::hardware_concurrency()));
+        debugScanner = std::make_unique<DebugScanner>(options.debugScanOptions, *scanPool);
+        session.useDebugScanner(debugScanner.get());
     }
-    return str;
-}
-void simulateTerminalTyping(const std::string& command) {
-    std::cout << "\n=======================================================" << std::endl;
-    std::cout << "[ORCHESTRATOR SIMULATING TERMINAL ACTION]: Executing command: '" << command << "'" << std::endl;
-    std::cout << "=======================================================\n" << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-}
+    std::unique_ptr<WorkStealingPool> validationPool;
+    std::unique_ptr<ValidationRunner> validationRunner;
+    if (!options.validationManifest.empty() && ValidationRunner::exists(options.validationManifest)) {
+        validationPool = std::make_unique<WorkStealingPool>(options.validationThreads > 0 ? options.validationThreads : std::max(1u, std::thread::hardware_concurrency()));
+        validationRunner = std::make_unique<ValidationRunner>(options.validationManifest, *validationPool);
+        std::string error;
+        if (!validationRunner->load(error)) {
+            logger.error() << "Error: " << error << ".";
+            return 1;
+        }
+        logger.info() << "[ORCHESTRATOR]: VALIDATION_TESTS will run the " << validationRunner->manifest().size() << " test units of '"
+                      << options.validationManifest << "'.";
+        session.useValidationRunner(validationRunner.get());
+    }
+    session.openKnowledge();
 
-void simulateCodeModification(const std::string& fileName, const std::string& modificationDescription) {
-    std::cout << "\n[ORCHESTRATOR]: Initiating self-modification protocol. Targeting '" << fileName << "' for " << modificationDescription << "." << std::endl;
-    simulateTerminalTyping("vim " + fileName);
-    std::cout << "[ORCHESTRATOR]: Analyzing code structure, identifying modification points, and auto-generating new code logic." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(2));
-    std::cout << "[ORCHESTRATOR]: Applying generated patch/new code segment for '" << fileName << "'. This involves conceptual alteration of functional behavior." << std::endl;
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    std::cout << "[ORCHESTRATOR]: Self-modification complete. The internal logic of the research module has been conceptually updated." << std::endl;
-    simulateTerminalTyping("git diff " + fileName);
-    std::cout << "[ORCHESTRATOR]: Reviewed conceptual code changes to ensure internal consistency and functional correctness." << std::endl;
-}
+    metrics.completeness.set(config.researchCompletenessScore);
+    metrics.iteration.set(config.researchIteration);
+    std::unique_ptr<MetricsExporter> metricsExporter;
+    if (!options.metricsPath.empty()) {
+        metricsExporter = std::make_unique<MetricsExporter>(metricsRegistry, options.metricsPath, options.metricsInterval);
+    }
 
-int main() {
-    ProgramConfig config;
-    config.load("config.json");
-
-    std::cout << "--- Autonomous Self-Modifying Deep Research Program (C++ Orchestrator) ---" << std::endl;
-    std::cout << "Current Research Topic: " << config.researchTopic << std::endl;
-    std::cout << "Current Iteration: " << config.researchIteration << std::endl;
-    std::cout << "Last Research Summary: " << config.lastResearchSummary << std::endl;
-    std::cout << "Last Error: " << config.lastErrorMessage << std::endl;
-    std::cout << "Llama3 Simulated Downloaded: " << (config.llama3SimulatedDownloaded ? "Yes" : "No") << std::endl;
-    std::cout << "Current Phase: ";
-    switch (config.currentPhase) {
-        case ProgramPhase::INITIAL_SETUP: std::cout << "INITIAL_SETUP"; break;
-        case ProgramPhase::RESEARCH_CYCLE: std::cout << "RESEARCH_CYCLE"; break;
-        case ProgramPhase::LLM_INTEGRATION: std::cout << "LLM_INTEGRATION"; break;
-        case ProgramPhase::DEBUGGING: std::cout << "DEBUGGING"; break;
-        case ProgramPhase::VALIDATION_TESTS: std::cout << "VALIDATION_TESTS"; break;
-        case ProgramPhase::FINAL_ANALYSIS: std::cout << "FINAL_ANALYSIS"; break;
-        case ProgramPhase::QUESTION_ANSWERING: std::cout << "QUESTION_ANSWERING"; break;
-        case ProgramPhase::COMPLETE: std::cout << "COMPLETE"; break;
-        case ProgramPhase::STALLED_UNRECOVERABLE: std::cout << "STALLED_UNRECOVERABLE"; break;
+    logger.info() << "--- Autonomous Self-Modifying Deep Research Program (C++ Orchestrator) ---";
+    logger.info() << "Current Research Topic: " << config.researchTopic.display();
+    logger.info() << "Current Iteration: " << config.researchIteration;
+    logger.info() << "Last Research Summary: " << config.lastResearchSummary;
+    logger.info() << "Last Error: " << config.lastErrorMessage;
+    logger.info() << "Llama3 Simulated Downloaded: " << (config.llama3SimulatedDownloaded ? "Yes" : "No");
+    logger.info() << "Current Phase: " << phaseToString(config.currentPhase);
+    logger.info() << "Research Completeness: " << config.researchCompletenessScore << "%";
+    logger.info() << "Knowledge Base: " << knowledge.size() << " passages in '" << knowledge.directory() << "'";
+    logger.info() << "Pacing: " << pacer.describe();
+    logger.info() << "---------------------------------------------------------";
+
+    while (!session.finished()) {
+        session.step();
     }
-    std::cout << std::endl;
-    std::cout << "Research Completeness: " << config.researchCompletenessScore << "%" << std::endl;
-    std::cout << "---------------------------------------------------------" << std::endl;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(0.0, 1.0);
-
-    while (config.currentPhase != ProgramPhase::COMPLETE &&
-           config.currentPhase != ProgramPhase::QUESTION_ANSWERING &&
-           config.currentPhase != ProgramPhase::STALLED_UNRECOVERABLE) {
-        config.researchIteration++;
-
-        std::cout << "\n--- Current Phase: ";
-        switch (config.currentPhase) {
-            case ProgramPhase::INITIAL_SETUP: std::cout << "INITIAL_SETUP ---" << std::endl;
-                std::cout << "[ORCHESTRATOR]: Commencing initial project setup and environment configuration." << std::endl;
-                simulateTerminalTyping("git clone https://github.com/autonomous-deep-research/project.git");
-                std::cout << "[ORCHESTRATOR]: Repository cloned successfully. Now inspecting the project for foundational components." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-                simulateTerminalTyping("ls -F");
-                std::cout << "[ORCHESTRATOR]: Identified source directories and configuration files. Proceeding with dependency analysis." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-                simulateTerminalTyping("pip install -r requirements.txt");
-                std::cout << "[ORCHESTRATOR]: All initial dependencies installed and verified. Environment is ready for core operations." << std::endl;
-                config.currentPhase = ProgramPhase::RESEARCH_CYCLE;
-                break;
-
-            case ProgramPhase::RESEARCH_CYCLE: std::cout << "RESEARCH_CYCLE ---" << std::endl;
-                std::cout << "[ORCHESTRATOR]: Initiating Deep Research Cycle #" << config.researchIteration << " on current topic: '" << config.researchTopic << "'." << std::endl;
-                simulateTerminalTyping("./rust_researcher \"" + config.researchTopic + "\" " + std::to_string(config.researchIteration));
-
-                {
-                    std::string rust_command = "./rust_researcher \"" + config.researchTopic + "\" " + std::to_string(config.researchIteration);
-                    std::string research_output = execCommand(rust_command.c_str());
-                    std::cout << "[ORCHESTRATOR]: Captured output from Rust Researcher:\n" << research_output << std::endl;
-
-                    std::map<std::string, std::string> rust_results = parseJson(research_output);
-
-                    if (rust_results.count("research_summary")) {
-                        config.lastResearchSummary = rust_results["research_summary"];
-                        std::cout << "[ORCHESTRATOR]: Updated internal research summary based on the latest findings from the Rust module." << std::endl;
-                    }
-                    if (rust_results.count("research_completeness_score")) {
-                         config.researchCompletenessScore = std::stod(rust_results["research_completeness_score"]);
-                         std::cout << "[ORCHESTRATOR]: Progress update: Research completeness score is now " << config.researchCompletenessScore << "%." << std::endl;
-                    }
-
-                    if (rust_results.count("error_found") && rust_results["error_found"] == "true") {
-                        config.lastErrorMessage = rust_results.count("error_message") ? rust_results["error_message"] : "Unknown error from researcher.";
-                        std::cout << "[ORCHESTRATOR]: Critical anomaly detected during research. Transitioning to DEBUGGING phase for immediate self-correction." << std::endl;
-                        config.currentPhase = ProgramPhase::DEBUGGING;
-                    } else {
-                        config.lastErrorMessage = "None";
-                        config.debugAttempts = 0;
-                        if (config.researchIteration % 2 == 0 && config.researchCompletenessScore < 90) {
-                            config.researchTopic = "deepen_" + config.researchTopic;
-                            std::cout << "[ORCHESTRATOR]: Current research trajectory stable. Initiating deeper exploration into '" << config.researchTopic << "' to extract more granular insights." << std::endl;
-                        }
-
-                        if (config.researchCompletenessScore >= 99.0 && !config.lastErrorMessage.empty() && config.lastErrorMessage == "None") {
-                            config.researchComplete = true;
-                            std::cout << "[ORCHESTRATOR]: Core research objectives are fulfilled. Entering FINAL_ANALYSIS phase to synthesize conclusive findings." << std::endl;
-                            config.currentPhase = ProgramPhase::FINAL_ANALYSIS;
-                        } else if (config.researchIteration >= 3 && !config.llama3SimulatedDownloaded && dis(gen) < 0.7) {
-                            config.currentPhase = ProgramPhase::LLM_INTEGRATION;
-                            std::cout << "[ORCHESTRATOR]: Sufficient foundational context acquired. Preparing for Llama3 8B integration to elevate research capabilities." << std::endl;
-                        }
-                    }
-                }
-                break;
-
-            case ProgramPhase::LLM_INTEGRATION: std::cout << "LLM_INTEGRATION ---" << std::endl;
-                if (!config.llama3SimulatedDownloaded) {
-                    std::cout << "\n[ORCHESTRATOR]: Initiating the intricate process of Llama3 8B model acquisition and environmental calibration." << std::endl;
-                    simulateTerminalTyping("wget https://simulated.llm-repo.org/llama3-8b.tar.gz -O ./models/llama3-8b.tar.gz");
-                    std::cout << "[ORCHESTRATOR]: Llama3 8B model download sequence initiated. Monitoring data stream integrity and progress..." << std::endl;
-                    std::this_thread::sleep_for(std::chrono::seconds(3));
-                    simulateTerminalTyping("tar -xzf ./models/llama3-8b.tar.gz -C ./models/");
-                    std::cout << "[ORCHESTRATOR]: Decompressing and extracting Llama3 8B model archives to designated directory. This is a resource-intensive operation." << std::endl;
-                    std::this_thread::sleep_for(std::chrono::seconds(2));
-                    simulateTerminalTyping("python3 -m venv llm_env && source llm_env/bin/activate");
-                    std::cout << "[ORCHESTRATOR]: Creating a dedicated, isolated Python virtual environment to host the Llama3 operations, ensuring no conflicts." << std::endl;
-                    std::this_thread::sleep_for(std::chrono::seconds(1));
-                    simulateTerminalTyping("pip install transformers torch accelerate bitsandbytes");
-                    std::cout << "[ORCHESTRATOR]: Installing essential Python libraries for Llama3 inference and fine-tuning. Optimizing for hardware acceleration." << std::endl;
-                    std::this_thread::sleep_for(std::chrono::seconds(2));
-                    std::cout << "[ORCHESTRATOR]: Llama3 8B model successfully integrated, validated, and prepared for advanced research queries and contextual understanding." << std::endl;
-                    config.llama3SimulatedDownloaded = true;
-                }
-                std::cout << "[ORCHESTRATOR]: Llama3 8B is now online. Resuming RESEARCH_CYCLE with profoundly enhanced analytical and generative capabilities." << std::endl;
-                config.currentPhase = ProgramPhase::RESEARCH_CYCLE;
-                break;
-
-            case ProgramPhase::DEBUGGING: std::cout << "DEBUGGING ---" << std::endl;
-                config.debugAttempts++;
-                std::cout << "[ORCHESTRATOR]: System anomaly identified: " << config.lastErrorMessage << ". Initiating precise diagnostic protocols (Attempt " << config.debugAttempts << "). Analyzing failure signature." << std::endl;
-                simulateTerminalTyping("find . -name '*.log' -exec tail -n 10 {} \\;");
-                std::cout << "[ORCHESTRATOR]: Retrieving and analyzing most recent log entries across all modules for comprehensive error tracing." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-                simulateTerminalTyping("grep -r '" + config.lastErrorMessage + "' ./src/");
-                std::cout << "[ORCHESTRATOR]: Executing targeted code search to pinpoint exact problematic functions or data structures related to the error." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(2));
-
-                simulateCodeModification("./rust_researcher/src/main.rs", "error resolution for '" + config.lastErrorMessage + "' based on diagnostic insights");
-                config.researchTopic = "fix_" + config.researchTopic;
-
-                std::cout << "[ORCHESTRATOR]: Transitioning to VALIDATION_TESTS phase to rigorously confirm the effectiveness of the self-applied code correction." << std::endl;
-                config.currentPhase = ProgramPhase::VALIDATION_TESTS;
-                break;
-
-            case ProgramPhase::VALIDATION_TESTS: std::cout << "VALIDATION_TESTS ---" << std::endl;
-                std::cout << "[ORCHESTRATOR]: Initiating a suite of comprehensive unit and integration tests to validate the integrity and effectiveness of the self-modification." << std::endl;
-                simulateTerminalTyping("cargo test --workspace -- --test-threads=1 --nocapture");
-                std::cout << "[ORCHESTRATOR]: Running all test cases, monitoring for any regressions or residual issues from the self-applied patch." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(3));
-                if (dis(gen) < 0.8 || config.debugAttempts >= 3) {
-                    std::cout << "[ORCHESTRATOR]: All self-tests passed successfully! The self-modification has been verified to resolve the issue and maintain system stability." << std::endl;
-                    simulateTerminalTyping("cargo build --release");
-                    std::cout << "[ORCHESTRATOR]: Recompiling the entire research module with the validated and integrated fixes. Resuming RESEARCH_CYCLE." << std::endl;
-                    config.lastErrorMessage = "None";
-                    config.currentPhase = ProgramPhase::RESEARCH_CYCLE;
-                    config.debugAttempts = 0;
-                } else {
-                    std::cout << "[ORCHESTRATOR]: Validation tests failed. The self-modification requires further refinement or a different approach. Re-entering DEBUGGING phase." << std::endl;
-                    config.currentPhase = ProgramPhase::DEBUGGING;
-                }
-
-                if (config.debugAttempts >= 5) {
-                    std::cout << "[ORCHESTRATOR CRITICAL FAILURE]: Multiple debug attempts and validation failures indicate a deeply embedded, unrecoverable systemic error. Autonomous operation cannot continue." << std::endl;
-                    config.lastErrorMessage = "Unrecoverable systemic error after " + std::to_string(config.debugAttempts) + " attempts. Manual intervention required.";
-                    config.currentPhase = ProgramPhase::STALLED_UNRECOVERABLE;
-                    config.researchComplete = false;
-                }
-                break;
-
-            case ProgramPhase::FINAL_ANALYSIS: std::cout << "FINAL_ANALYSIS ---" << std::endl;
-                std::cout << "[ORCHESTRATOR]: Entering the FINAL_ANALYSIS phase: Synthesizing all accumulated data into a cohesive, actionable knowledge base." << std::endl;
-                simulateTerminalTyping("python3 ./scripts/consolidate_data.py --input_dir ./research_data/ --output_dir ./final_reports/ --optimize --cross-validate");
-                std::cout << "[ORCHESTRATOR]: All iterative findings, self-corrections, and LLM-enhanced insights are being rigorously aggregated." << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(3));
-                simulateTerminalTyping("python3 ./scripts/generate_report.py --knowledge_base ./final_reports/ --format markdown --detailed --peer-review --executive-summary");
-                std::cout << "[ORCHESTRATOR]: Comprehensive final report generated, encompassing all validated conclusions and supporting evidence. The deep research is now functionally complete and available for inquiry." << std::endl;
-                config.currentPhase = ProgramPhase::QUESTION_ANSWERING;
-                config.researchComplete = true;
-                break;
-
-            default:
-                std::cout << "[ORCHESTRATOR FATAL ERROR]: Encountered an unhandled or unexpected program phase. Terminating autonomous operations immediately." << std::endl;
-                config.currentPhase = ProgramPhase::COMPLETE;
-                break;
+    session.compact();
+    if (metricsExporter) metricsExporter->exportNow();
+    Logger::setContext(config.researchIteration, phaseToString(config.currentPhase));
+
+    logger.notice() << "\n--- Autonomous Deep Research Process Concluded ---";
+    logger.notice() << "[ORCHESTRATOR]: Final Research Summary: " << config.lastResearchSummary;
+    logger.notice() << "[ORCHESTRATOR]: Final System Error State: " << config.lastErrorMessage;
+    logger.notice() << "[ORCHESTRATOR]: Overall Research Completeness: " << config.researchCompletenessScore << "%";
+    {
+        LogLine totals = logger.info();
+        totals << "[ORCHESTRATOR]: Time per phase this run (" << pacer.elapsed().count() / 1000.0 << "s total):";
+        for (size_t i = 0; i < kPhaseCount; ++i) {
+            Pacer::Duration total = session.phaseTotal(static_cast<ProgramPhase>(i));
+            if (total.count() > 0) totals << " " << phaseToString(static_cast<ProgramPhase>(i)) << "=" << total.count() / 1000.0 << "s";
         }
-
-        config.save("config.json");
-        std::cout << "[ORCHESTRATOR]: Current operational state and research progress saved to 'config.json' for persistent memory." << std::endl;
-        std::this_thread::sleep_for(std::chrono::seconds(1));
     }
-
-    std::cout << "\n--- Autonomous Deep Research Process Concluded ---" << std::endl;
-    std::cout << "[ORCHESTRATOR]: Final Research Summary: " << config.lastResearchSummary << std::endl;
-    std::cout << "[ORCHESTRATOR]: Final System Error State: " << config.lastErrorMessage << std::endl;
-    std::cout << "[ORCHESTRATOR]: Overall Research Completeness: " << config.researchCompletenessScore << "%" << std::endl;
-    std::cout << "---------------------------------------------------" << std::endl;
+    if (resultCache) {
+        const ResultCacheStats& stats = resultCache->stats();
+        logger.info() << "[ORCHESTRATOR]: Researcher result cache: " << stats.memoryHits << " memory hits, " << stats.diskHits
+                      << " disk hits, " << stats.misses << " misses, " << stats.stores << " stored, " << stats.memoryEvictions
+                      << " evicted from memory, " << stats.diskEvictions << " from disk.";
+    }
+    if (metricsExporter) {
+        logger.info() << "[ORCHESTRATOR]: Metrics (Prometheus text format) exported to '" << options.metricsPath << "' every "
+                      << options.metricsInterval.count() / 1000.0 << "s.";
+    }
+    logger.notice() << "---------------------------------------------------";
 
     if (config.currentPhase == ProgramPhase::STALLED_UNRECOVERABLE) {
-        std::cout << "\n[ORCHESTRATOR WARNING]: The autonomous deep research process has reached an unrecoverable state due to persistent systemic issues. Human intervention is critically required to diagnose and resolve the fundamental problem: " << config.lastErrorMessage << std::endl;
-        std::cout << "[ORCHESTRATOR]: Please analyze the debug logs and current configuration for manual troubleshooting." << std::endl;
+        logger.warning() << "\n[ORCHESTRATOR WARNING]: The autonomous deep research process has reached an unrecoverable state due to persistent systemic issues. Human intervention is critically required to diagnose and resolve the fundamental problem: " << config.lastErrorMessage;
+        logger.notice() << "[ORCHESTRATOR]: Please analyze the debug logs and current configuration for manual troubleshooting.";
+        logger.flush(true);
         return 1;
     }
 
+    if (!options.serveSocket.empty() || !options.answerBatchPath.empty()) {
+        int status = answerNonInteractively(options, logger, knowledge, config, metrics);
+        if (metricsExporter) metricsExporter->exportNow();
+        logger.flush(true);
+        return status;
+    }
+
     std::string userQuestion;
-    std::cout << "\n[ORCHESTRATOR]: Deep research operations are fully complete. I am now prepared to provide comprehensive, research-level answers to your questions, leveraging all accumulated knowledge. (Type 'exit' to quit)\n";
-    std::cout << "Your Question: ";
+    std::vector<KnowledgeHit> passages;
+    logger.notice() << "\n[ORCHESTRATOR]: Deep research operations are fully complete. I am now prepared to provide comprehensive, research-level answers to your questions, leveraging all accumulated knowledge. (Type 'exit' to quit)";
+    logger.prompt("Your Question: ");
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
     std::getline(std::cin, userQuestion);
 
-    while (userQuestion != "exit") {
-        std::cout << "\n--- Providing Deep Research Answer ---" << std::endl;
-        std::cout << "[ORCHESTRATOR]: Initiating advanced query processing for your question: \"" << userQuestion << "\"" << std::endl;
+    while (std::cin && userQuestion != "exit") {
+        logger.notice() << "\n--- Providing Deep Research Answer ---";
+        logger.info() << "[ORCHESTRATOR]: Initiating advanced query processing for your question: \"" << userQuestion << "\"";
+
+        auto retrievalStarted = std::chrono::steady_clock::now();
+        knowledge.search(userQuestion, options.answerPassages, passages);
+        auto retrievalElapsed = std::chrono::steady_clock::now() - retrievalStarted;
+        metrics.knowledgeSearch.record(retrievalElapsed);
+        auto retrievalTime = std::chrono::duration_cast<std::chrono::microseconds>(retrievalElapsed);
+        logger.info() << "[ORCHESTRATOR]: Retrieved " << passages.size() << " relevant passages out of " << knowledge.size() << " in " << retrievalTime.count() << " us:";
+        for (const KnowledgeHit& passage : passages) {
+            logger.notice() << "  [iteration " << passage.iteration << ", topic '" << passage.topic << "', score " << passage.score << "] " << passage.text;
+        }
 
-        std::cout << "[ORCHESTRATOR]: Accessing the validated knowledge base and leveraging its full analytical power. Based on our extensive, self-optimizing deep research, which encompassed multiple iterative cycles, continuous self-correction protocols, and fundamentally utilized ";
-        if (config.llama3SimulatedDownloaded) {
-            std::cout << "the integrated Llama3 8B model for advanced pattern recognition, complex inference, and nuanced conceptual understanding, ";
-        } else {
-            std::cout << "extensive data analysis, iterative refinement of methodologies, robust error handling, and adaptive algorithmic adjustments throughout its execution, ";
+        {
+            LogLine approach = logger.notice();
+            approach << "[ORCHESTRATOR]: Accessing the validated knowledge base and leveraging its full analytical power. Based on our extensive, self-optimizing deep research, which encompassed multiple iterative cycles, continuous self-correction protocols, and fundamentally utilized ";
+            if (config.llama3SimulatedDownloaded) {
+                approach << "the integrated Llama3 8B model for advanced pattern recognition, complex inference, and nuanced conceptual understanding, ";
+            } else {
+                approach << "extensive data analysis, iterative refinement of methodologies, robust error handling, and adaptive algorithmic adjustments throughout its execution, ";
+            }
+            approach << "all conducted on the topic of '" << config.researchTopic.base() << "':";
         }
-        std::cout << "all conducted on the topic of '" << replaceAll(replaceAll(replaceAll(config.researchTopic, "deepen_", ""), "fix_", ""), "refine_", "") << "':" << std::endl;
 
-        std::cout << "[ORCHESTRATOR]: Our synthesized findings, derived from a rigorously validated and self-generated knowledge base, indicate that: " << config.lastResearchSummary << std::endl;
-        std::cout << "[ORCHESTRATOR]: Specifically addressing your inquiry regarding '" << userQuestion << "', our deep research reveals that "
-                  << "the core complexities of this domain have been meticulously dissected and synthesized through a process of iterative hypothesis generation, simulated empirical validation, and dynamic algorithmic adjustments. For instance, "
-                  << "earlier ambiguities, data inconsistencies, or logical paradoxes (identified and precisely resolved through our automated debugging phase, reinforced by multiple validation tests, and refined via continuous self-modification) "
-                  << "were absolutely pivotal in shaping the current robust and refined understanding. The comprehensive knowledge base, "
-                  << "achieving an exceptional " << config.researchCompletenessScore << "% completeness score and demonstrating high internal consistency, "
-                  << "**strongly supports the conclusion that: [SIMULATED LLM REASONING AND DEEP RESEARCH ANSWER HERE - This is where the core of the self-modifying, Llama3-enhanced, deep research capability culminates. A real, integrated LLM would process the user's question, access the entire simulated knowledge base (represented by `config.lastResearchSummary` and the `researchTopic` history), and generate a highly detailed, contextually relevant, nuanced, and accurate answer. This answer would demonstrate 'understanding' and 'research-level' depth, explicitly citing conceptual 'findings' and 'insights' from the simulated research process. It would be a dynamic response, reflecting the accumulated 'learning' and 'self-correction' of the system. For example, if the research was about 'renewable energy efficiency', and the user asked 'What are the main challenges in solar panel efficiency at night?', the LLM's simulated answer might talk about storage solutions, grid integration issues, and emerging battery technologies, all framed as 'findings from our deep research iteration X which highlighted Y problem and Z solution, further refined by Llama3's analysis of global energy trends'.]**" << std::endl;
+        logger.notice() << "[ORCHESTRATOR]: Our synthesized findings, derived from a rigorously validated and self-generated knowledge base, indicate that: " << (passages.empty() ? config.lastResearchSummary : passages.front().text);
+        logger.notice() << "[ORCHESTRATOR]: Specifically addressing your inquiry regarding '" << userQuestion << "', our deep research reveals that "
+                        << "the core complexities of this domain have been meticulously dissected and synthesized through a process of iterative hypothesis generation, simulated empirical validation, and dynamic algorithmic adjustments. For instance, "
+                        << "earlier ambiguities, data inconsistencies, or logical paradoxes (identified and precisely resolved through our automated debugging phase, reinforced by multiple validation tests, and refined via continuous self-modification) "
+                        << "were absolutely pivotal in shaping the current robust and refined understanding. The comprehensive knowledge base, "
+                        << "achieving an exceptional " << config.researchCompletenessScore << "% completeness score and demonstrating high internal consistency, "
+                        << "**strongly supports the conclusion that: [SIMULATED LLM REASONING AND DEEP RESEARCH ANSWER HERE - This is where the core of the self-modifying, Llama3-enhanced, deep research capability culminates. A real, integrated LLM would process the user's question, access the entire simulated knowledge base (represented by `config.lastResearchSummary` and the `researchTopic` history), and generate a highly detailed, contextually relevant, nuanced, and accurate answer. This answer would demonstrate 'understanding' and 'research-level' depth, explicitly citing conceptual 'findings' and 'insights' from the simulated research process. It would be a dynamic response, reflecting the accumulated 'learning' and 'self-correction' of the system. For example, if the research was about 'renewable energy efficiency', and the user asked 'What are the main challenges in solar panel efficiency at night?', the LLM's simulated answer might talk about storage solutions, grid integration issues, and emerging battery technologies, all framed as 'findings from our deep research iteration X which highlighted Y problem and Z solution, further refined by Llama3's analysis of global energy trends'.]**";
 
-        std::cout << "[ORCHESTRATOR]: This response is the culmination of our autonomous investigation, demonstrating the program's advanced capacity to derive complex, research-level answers from its continuous self-improvement and deep learning processes." << std::endl;
-        std::cout << "---------------------------------------" << std::endl;
+        logger.notice() << "[ORCHESTRATOR]: This response is the culmination of our autonomous investigation, demonstrating the program's advanced capacity to derive complex, research-level answers from its continuous self-improvement and deep learning processes.";
+        logger.notice() << "---------------------------------------";
 
-        std::cout << "\n[ORCHESTRATOR]: Please feel free to ask another question, or type 'exit' to conclude this session.\n";
-        std::cout << "Your Question: ";
+        logger.notice() << "\n[ORCHESTRATOR]: Please feel free to ask another question, or type 'exit' to conclude this session.";
+        logger.prompt("Your Question: ");
         std::getline(std::cin, userQuestion);
     }
 
-    std::cout << "[ORCHESTRATOR]: Program gracefully exited. Thank you for utilizing the Autonomous Deep Research System. Goodbye!" << std::endl;
+    logger.notice() << "[ORCHESTRATOR]: Program gracefully exited. Thank you for utilizing the Autonomous Deep Research System. Goodbye!";
 
     return 0;
 }
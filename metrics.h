@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "program_config.h"
+
+// Log-linear latency histogram in the style of HdrHistogram: values (in
+// nanoseconds) below 32 get exact buckets, above that each power of two is
+// split into 32 linear sub-buckets, so any recorded value is known to within
+// about 3%. Values are clamped at 2^40 ns (about 18 minutes). Recording is
+// three relaxed atomic adds and safe from any thread.
+class LatencyHistogram {
+public:
+    static constexpr int kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = 1u << kSubBucketBits;
+    static constexpr int kMaxExponent = 40;
+    static constexpr size_t kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+    void record(uint64_t nanoseconds) {
+        buckets[bucketFor(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+        samples.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(nanoseconds, std::memory_order_relaxed);
+    }
+
+    void record(std::chrono::steady_clock::duration elapsed) {
+        record(static_cast<uint64_t>(std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())));
+    }
+
+    uint64_t count() const { return samples.load(std::memory_order_relaxed); }
+    uint64_t sumNanoseconds() const { return total.load(std::memory_order_relaxed); }
+
+    // Upper bound of the bucket holding the q-th quantile (0 when empty).
+    uint64_t quantile(double q) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(n) + 0.999999);
+        rank = std::min(std::max<uint64_t>(rank, 1), n);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return bucketUpper(i);
+        }
+        return bucketUpper(kBucketCount - 1);
+    }
+
+    // Samples whose bucket lies entirely at or below `nanoseconds`.
+    uint64_t countAtOrBelow(uint64_t nanoseconds) const {
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount && bucketUpper(i) <= nanoseconds; ++i) seen += buckets[i].load(std::memory_order_relaxed);
+        return seen;
+    }
+
+    static size_t bucketFor(uint64_t value) {
+        if (value < kSubBuckets) return static_cast<size_t>(value);
+        int exponent = 63 - __builtin_clzll(value);
+        if (exponent > kMaxExponent) return kBucketCount - 1;
+        uint64_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+        return static_cast<size_t>((exponent - kSubBucketBits + 1) * kSubBuckets + sub);
+    }
+
+    static uint64_t bucketUpper(size_t index) {
+        if (index < kSubBuckets) return index;
+        int exponent = static_cast<int>(index / kSubBuckets) + kSubBucketBits - 1;
+        uint64_t sub = index % kSubBuckets;
+        return ((kSubBuckets + sub + 1) << (exponent - kSubBucketBits)) - 1;
+    }
+
+private:
+    std::atomic<uint64_t> buckets[kBucketCount] = {};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> total{0};
+};
+
+class Counter {
+public:
+    void increment(uint64_t by = 1) { value.fetch_add(by, std::memory_order_relaxed); }
+    uint64_t get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+class Gauge {
+public:
+    void set(double newValue) { value.store(newValue, std::memory_order_relaxed); }
+    double get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value{0.0};
+};
+
+// Records the monotonic time between construction and destruction.
+class ScopedSpan {
+public:
+    explicit ScopedSpan(LatencyHistogram& target) : histogram(target), started(std::chrono::steady_clock::now()) {}
+    ~ScopedSpan() { histogram.record(std::chrono::steady_clock::now() - started); }
+
+    ScopedSpan(const ScopedSpan&) = delete;
+    ScopedSpan& operator=(const ScopedSpan&) = delete;
+
+private:
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point started;
+};
+
+// Owns metrics and renders them in the Prometheus text exposition format.
+// Metrics are registered up front (registration is not thread-safe) and
+// live as long as the registry; the returned references are what the hot
+// path touches. `labels` is a preformatted label set such as
+// `phase="DEBUGGING"`. Series of one family are rendered together, in
+// registration order. Counters and histograms with no samples are skipped.
+class MetricsRegistry {
+public:
+    Counter& counter(const std::string& name, const std::string& help, const std::string& labels = "") {
+        counters.emplace_back();
+        add(name, help, "counter", labels, Kind::COUNTER, counters.size() - 1);
+        return counters.back();
+    }
+
+    Gauge& gauge(const std::string& name, const std::string& help, const std::string& labels = "") {
+        gauges.emplace_back();
+        add(name, help, "gauge", labels, Kind::GAUGE, gauges.size() - 1);
+        return gauges.back();
+    }
+
+    // Exposed in seconds as a Prometheus histogram plus p50/p90/p99 gauges
+    // (`<name>_quantile`), both at the histogram's bucket resolution.
+    LatencyHistogram& histogram(const std::string& name, const std::string& help, const std::string& labels = "") {
+        histograms.emplace_back();
+        add(name, help, "histogram", labels, Kind::HISTOGRAM, histograms.size() - 1);
+        return histograms.back();
+    }
+
+    void render(std::string& out) const {
+        out.clear();
+        for (const Family& family : families) {
+            size_t familyStart = out.size();
+            bool any = false;
+            out += "# HELP " + family.name + " " + family.help + "\n";
+            out += "# TYPE " + family.name + " " + family.type + "\n";
+            for (const Series& series : family.series) any = renderSeries(family, series, out) || any;
+            if (!any) out.resize(familyStart);
+        }
+        for (const Family& family : families) {
+            if (family.type != "histogram") continue;
+            size_t familyStart = out.size();
+            bool any = false;
+            out += "# HELP " + family.name + "_quantile " + family.help + " (quantiles)\n";
+            out += "# TYPE " + family.name + "_quantile gauge\n";
+            for (const Series& series : family.series) {
+                const LatencyHistogram& h = histograms[series.index];
+                if (h.count() == 0) continue;
+                any = true;
+                for (double q : {0.5, 0.9, 0.99}) {
+                    char quantile[16];
+                    std::snprintf(quantile, sizeof(quantile), "%g", q);
+                    out += family.name + "_quantile" + labelSet(series.labels, std::string("quantile=\"") + quantile + "\"") + " " + formatSeconds(h.quantile(q)) + "\n";
+                }
+            }
+            if (!any) out.resize(familyStart);
+        }
+    }
+
+    // Writes the rendering atomically, so a scraper never sees half a file.
+    bool writeTo(const std::string& path) const {
+        thread_local std::string buffer;
+        render(buffer);
+        return writeFileAtomically(path, buffer);
+    }
+
+private:
+    enum class Kind { COUNTER, GAUGE, HISTOGRAM };
+
+    struct Series {
+        std::string labels;
+        Kind kind;
+        size_t index;
+    };
+
+    struct Family {
+        std::string name;
+        std::string help;
+        std::string type;
+        std::vector<Series> series;
+    };
+
+    void add(const std::string& name, const std::string& help, const char* type, const std::string& labels, Kind kind, size_t index) {
+        auto found = std::find_if(families.begin(), families.end(), [&](const Family& family) { return family.name == name; });
+        if (found == families.end()) {
+            families.push_back(Family{name, help, type, {}});
+            found = families.end() - 1;
+        }
+        found->series.push_back(Series{labels, kind, index});
+    }
+
+    static std::string labelSet(const std::string& labels, const std::string& extra = "") {
+        if (labels.empty() && extra.empty()) return "";
+        if (labels.empty()) return "{" + extra + "}";
+        if (extra.empty()) return "{" + labels + "}";
+        return "{" + labels + "," + extra + "}";
+    }
+
+    static std::string formatNumber(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.10g", value);
+        return buffer;
+    }
+
+    static std::string formatSeconds(uint64_t nanoseconds) { return formatNumber(static_cast<double>(nanoseconds) / 1e9); }
+
+    bool renderSeries(const Family& family, const Series& series, std::string& out) const {
+        switch (series.kind) {
+            case Kind::COUNTER: {
+                uint64_t value = counters[series.index].get();
+                if (value == 0) return false;
+                out += family.name + labelSet(series.labels) + " " + std::to_string(value) + "\n";
+                return true;
+            }
+            case Kind::GAUGE:
+                out += family.name + labelSet(series.labels) + " " + formatNumber(gauges[series.index].get()) + "\n";
+                return true;
+            case Kind::HISTOGRAM: {
+                const LatencyHistogram& h = histograms[series.index];
+                uint64_t count = h.count();
+                if (count == 0) return false;
+                // 1-2.5-5 steps from 1us to 100s.
+                static const uint64_t bounds[] = {
+                    1000ull, 2500ull, 5000ull, 10000ull, 25000ull, 50000ull, 100000ull, 250000ull, 500000ull,
+                    1000000ull, 2500000ull, 5000000ull, 10000000ull, 25000000ull, 50000000ull, 100000000ull,
+                    250000000ull, 500000000ull, 1000000000ull, 2500000000ull, 5000000000ull, 10000000000ull,
+                    25000000000ull, 50000000000ull, 100000000000ull};
+                for (uint64_t bound : bounds) {
+                    out += family.name + "_bucket" + labelSet(series.labels, "le=\"" + formatSeconds(bound) + "\"") + " " + std::to_string(h.countAtOrBelow(bound)) + "\n";
+                }
+                out += family.name + "_bucket" + labelSet(series.labels, "le=\"+Inf\"") + " " + std::to_string(count) + "\n";
+                out += family.name + "_sum" + labelSet(series.labels) + " " + formatSeconds(h.sumNanoseconds()) + "\n";
+                out += family.name + "_count" + labelSet(series.labels) + " " + std::to_string(count) + "\n";
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Family> families;
+    std::deque<Counter> counters;
+    std::deque<Gauge> gauges;
+    std::deque<LatencyHistogram> histograms;
+};
+
+// Rewrites `path` from a background thread every `interval`, and once more
+// on destruction so the file reflects the end of the run.
+class MetricsExporter {
+public:
+    MetricsExporter(const MetricsRegistry& source, std::string outputPath, std::chrono::milliseconds exportInterval)
+        : registry(source), path(std::move(outputPath)), interval(exportInterval) {
+        if (interval.count() > 0) worker = std::thread([this] { run(); });
+    }
+
+    ~MetricsExporter() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+        exportNow();
+    }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    bool exportNow() {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (registry.writeTo(path)) return true;
+        if (!warned) std::cerr << "Warning: Could not write metrics file '" << path << "'." << std::endl;
+        warned = true;
+        return false;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!wake.wait_for(lock, interval, [&] { return stopping; })) {
+            lock.unlock();
+            exportNow();
+            lock.lock();
+        }
+    }
+
+    const MetricsRegistry& registry;
+    std::string path;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::mutex writeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    bool warned = false;
+    std::thread worker;
+};
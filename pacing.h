@@ -0,0 +1,97 @@
+#pragma once
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+
+enum class PacingMode {
+    REAL_TIME,
+    SCALED,
+    VIRTUAL
+};
+
+// Stands in for the orchestrator's scripted delays. Every pause advances a
+// virtual clock by its nominal duration whatever the mode, so phase durations
+// reported from elapsed() are identical across real-time, scaled and virtual
+// runs; the modes differ only in how long the thread actually sleeps.
+//
+// A deferred pacer never sleeps itself: it adds up the time it would have
+// slept, and an event loop collects it with takeDeferred() and schedules the
+// caller's next step that much later instead of blocking a thread.
+class Pacer {
+public:
+    using Duration = std::chrono::milliseconds;
+
+    explicit Pacer(PacingMode pacingMode = PacingMode::REAL_TIME, double speedupFactor = 1.0)
+        : currentMode(pacingMode), speedup(speedupFactor > 0.0 ? speedupFactor : 1.0) {}
+
+    void pause(Duration nominal) {
+        virtualElapsed += nominal;
+        std::chrono::microseconds sleep{0};
+        switch (currentMode) {
+            case PacingMode::REAL_TIME:
+                sleep = nominal;
+                break;
+            case PacingMode::SCALED:
+                sleep = std::chrono::microseconds(static_cast<long long>(nominal.count() * 1000.0 / speedup));
+                break;
+            case PacingMode::VIRTUAL:
+                break;
+        }
+        if (deferred) owed += sleep;
+        else if (sleep.count() > 0) std::this_thread::sleep_for(sleep);
+    }
+
+    void setDeferred(bool enabled) { deferred = enabled; }
+
+    // Real time the deferred pauses since the last call would have slept.
+    std::chrono::microseconds takeDeferred() {
+        std::chrono::microseconds result = owed;
+        owed = std::chrono::microseconds(0);
+        return result;
+    }
+
+    // Total nominal time of all pauses so far.
+    Duration elapsed() const { return virtualElapsed; }
+    PacingMode mode() const { return currentMode; }
+
+    std::string describe() const {
+        switch (currentMode) {
+            case PacingMode::REAL_TIME: return "real-time";
+            case PacingMode::SCALED: return "scaled " + std::to_string(speedup) + "x";
+            case PacingMode::VIRTUAL: return "virtual clock (no sleeping)";
+        }
+        return "unknown";
+    }
+
+    // Accepts "realtime", "virtual" or a speedup such as "100x".
+    static bool parse(std::string_view text, Pacer& out) {
+        if (text == "realtime" || text == "real-time") {
+            out = Pacer(PacingMode::REAL_TIME);
+            return true;
+        }
+        if (text == "virtual") {
+            out = Pacer(PacingMode::VIRTUAL);
+            return true;
+        }
+        if (text.size() > 1 && text.back() == 'x') {
+            std::string factor(text.substr(0, text.size() - 1));
+            char* end = nullptr;
+            double value = std::strtod(factor.c_str(), &end);
+            if (end != factor.c_str() && *end == '\0' && value > 0.0) {
+                out = Pacer(PacingMode::SCALED, value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    PacingMode currentMode;
+    double speedup;
+    Duration virtualElapsed{0};
+    bool deferred = false;
+    std::chrono::microseconds owed{0};
+};
@@ -0,0 +1,30 @@
+#pragma once
+
+// The random and threshold decisions of the phase state machine. The
+// session makes each decision through these, and the simulator
+// (phase_simulator.h) reuses them, so both move together when a threshold
+// changes. `draw` returns a uniform double in [0, 1). Each decision draws
+// exactly when the original inline code did, so a seeded run still takes
+// the same path.
+struct PhaseRules {
+    double llmIntegrationChance = 0.7; // per successful research cycle, once eligible
+    int llmIntegrationAfter = 3;       // first research iteration eligible for LLM_INTEGRATION
+    double validationPassRate = 0.8;
+    int forcedPassAfter = 3;           // debug attempts after which validation always passes
+    int stallAfter = 5;                // debug attempts that make the run unrecoverable
+    double completeScore = 99.0;       // completeness that ends research
+
+    bool researchConcluded(double completenessScore) const { return completenessScore >= completeScore; }
+
+    template <class Draw>
+    bool entersLlmIntegration(int researchIteration, bool llmDownloaded, Draw&& draw) const {
+        return researchIteration >= llmIntegrationAfter && !llmDownloaded && draw() < llmIntegrationChance;
+    }
+
+    template <class Draw>
+    bool validationPasses(int debugAttempts, Draw&& draw) const {
+        return draw() < validationPassRate || debugAttempts >= forcedPassAfter;
+    }
+
+    bool debugExhausted(int debugAttempts) const { return debugAttempts >= stallAfter; }
+};
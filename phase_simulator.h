@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "phase_rules.h"
+#include "program_config.h"
+#include "work_pool.h"
+
+// Stand-in for the researcher in simulated runs. The defaults follow the
+// stub researcher: an error every fifth call, ten points of completeness
+// per call.
+struct ResearchModel {
+    double errorRate = 0.2;  // chance a research cycle reports error_found
+    double scoreGain = 10.0; // completeness added per research cycle, capped at 100
+};
+
+struct SimulationParameters {
+    PhaseRules rules;
+    ResearchModel research;
+};
+
+// Sets the parameter named as on the command line ("validation-pass-rate").
+inline bool setSimulationParameter(SimulationParameters& parameters, std::string_view name, double value) {
+    PhaseRules& rules = parameters.rules;
+    if (name == "llm-chance") rules.llmIntegrationChance = value;
+    else if (name == "llm-after") rules.llmIntegrationAfter = static_cast<int>(value);
+    else if (name == "validation-pass-rate") rules.validationPassRate = value;
+    else if (name == "forced-pass-after") rules.forcedPassAfter = static_cast<int>(value);
+    else if (name == "stall-after") rules.stallAfter = static_cast<int>(value);
+    else if (name == "complete-score") rules.completeScore = value;
+    else if (name == "error-rate") parameters.research.errorRate = value;
+    else if (name == "score-gain") parameters.research.scoreGain = value;
+    else return false;
+    return true;
+}
+
+// One swept parameter: "<name>=<from>[:<to>:<step>]".
+struct SweepAxis {
+    std::string name;
+    std::vector<double> values;
+
+    bool parse(std::string_view text) {
+        size_t equals = text.find('=');
+        if (equals == std::string_view::npos || equals == 0) return false;
+        name.assign(text.substr(0, equals));
+        SimulationParameters probe;
+        if (!setSimulationParameter(probe, name, 0.0)) return false;
+
+        std::string range(text.substr(equals + 1));
+        const char* cursor = range.c_str();
+        char* end = nullptr;
+        double from = std::strtod(cursor, &end);
+        if (end == cursor) return false;
+        double to = from;
+        double step = 1.0;
+        if (*end == ':') {
+            cursor = end + 1;
+            to = std::strtod(cursor, &end);
+            if (end == cursor || *end != ':') return false;
+            cursor = end + 1;
+            step = std::strtod(cursor, &end);
+            if (end == cursor || !(step > 0.0) || to < from) return false;
+        }
+        if (*end != '\0') return false;
+        values.clear();
+        // The epsilon keeps "0.5:0.9:0.1" from losing 0.9 to rounding.
+        size_t count = static_cast<size_t>(std::floor((to - from) / step + 1e-9)) + 1;
+        for (size_t i = 0; i < count; ++i) values.push_back(from + static_cast<double>(i) * step);
+        return true;
+    }
+};
+
+// Every combination of the axes' values applied to `base`, the first axis
+// varying slowest. `labels` names each point ("stall-after=4 error-rate=0.3").
+inline void expandSweep(const std::vector<SweepAxis>& axes, const SimulationParameters& base,
+                        std::vector<SimulationParameters>& points, std::vector<std::string>& labels) {
+    points.assign(1, base);
+    labels.assign(1, "");
+    for (const SweepAxis& axis : axes) {
+        std::vector<SimulationParameters> nextPoints;
+        std::vector<std::string> nextLabels;
+        for (size_t i = 0; i < points.size(); ++i) {
+            for (double value : axis.values) {
+                nextPoints.push_back(points[i]);
+                setSimulationParameter(nextPoints.back(), axis.name, value);
+                char formatted[32];
+                std::snprintf(formatted, sizeof(formatted), "%g", value);
+                nextLabels.push_back(labels[i] + (labels[i].empty() ? "" : " ") + axis.name + "=" + formatted);
+            }
+        }
+        points.swap(nextPoints);
+        labels.swap(nextLabels);
+    }
+    if (axes.empty()) labels[0] = "defaults";
+}
+
+// Uniform [0, 1) doubles from eight interleaved xoshiro256+ generators. A
+// refill steps all eight in lockstep over structure-of-arrays state, a loop
+// the compiler vectorizes, and the trajectories then consume the block one
+// value at a time.
+class UniformBlockStream {
+public:
+    explicit UniformBlockStream(uint64_t seed) {
+        uint64_t mix = seed;
+        for (size_t lane = 0; lane < kLanes; ++lane) {
+            s0[lane] = splitMix(mix);
+            s1[lane] = splitMix(mix);
+            s2[lane] = splitMix(mix);
+            s3[lane] = splitMix(mix);
+        }
+        refill();
+    }
+
+    double operator()() {
+        if (next == kBlock) refill();
+        return values[next++];
+    }
+
+private:
+    static constexpr size_t kLanes = 8;
+    static constexpr size_t kBlock = 512;
+
+    static uint64_t splitMix(uint64_t& state) {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    void refill() {
+        for (size_t base = 0; base < kBlock; base += kLanes) {
+            for (size_t lane = 0; lane < kLanes; ++lane) {
+                uint64_t result = s0[lane] + s3[lane];
+                uint64_t shifted = s1[lane] << 17;
+                s2[lane] ^= s0[lane];
+                s3[lane] ^= s1[lane];
+                s1[lane] ^= s2[lane];
+                s0[lane] ^= s3[lane];
+                s2[lane] ^= shifted;
+                s3[lane] = (s3[lane] << 45) | (s3[lane] >> 19);
+                values[base + lane] = static_cast<double>(result >> 11) * 0x1.0p-53;
+            }
+        }
+        next = 0;
+    }
+
+    uint64_t s0[kLanes], s1[kLanes], s2[kLanes], s3[kLanes];
+    double values[kBlock];
+    size_t next = 0;
+};
+
+// The fields of ProgramConfig that drive phase transitions.
+struct SimulatedRun {
+    ProgramPhase phase = ProgramPhase::INITIAL_SETUP;
+    int iteration = 0;
+    int debugAttempts = 0;
+    double score = 0.0;
+    bool llmDownloaded = false;
+
+    bool finished() const {
+        return phase == ProgramPhase::COMPLETE || phase == ProgramPhase::QUESTION_ANSWERING || phase == ProgramPhase::STALLED_UNRECOVERABLE;
+    }
+};
+
+// One ResearchSession iteration without I/O, logging or pacing: the same
+// transitions, decided through the same PhaseRules, with the researcher
+// replaced by parameters.research.
+template <class Draw>
+void simulateIteration(const SimulationParameters& parameters, SimulatedRun& run, Draw& draw) {
+    const PhaseRules& rules = parameters.rules;
+    run.iteration++;
+    switch (run.phase) {
+        case ProgramPhase::INITIAL_SETUP:
+            run.phase = ProgramPhase::RESEARCH_CYCLE;
+            break;
+        case ProgramPhase::RESEARCH_CYCLE:
+            run.score = std::min(100.0, run.score + parameters.research.scoreGain);
+            if (draw() < parameters.research.errorRate) {
+                run.phase = ProgramPhase::DEBUGGING;
+            } else {
+                run.debugAttempts = 0;
+                if (rules.researchConcluded(run.score)) run.phase = ProgramPhase::FINAL_ANALYSIS;
+                else if (rules.entersLlmIntegration(run.iteration, run.llmDownloaded, draw)) run.phase = ProgramPhase::LLM_INTEGRATION;
+            }
+            break;
+        case ProgramPhase::LLM_INTEGRATION:
+            run.llmDownloaded = true;
+            run.phase = ProgramPhase::RESEARCH_CYCLE;
+            break;
+        case ProgramPhase::DEBUGGING:
+            run.debugAttempts++;
+            run.phase = ProgramPhase::VALIDATION_TESTS;
+            break;
+        case ProgramPhase::VALIDATION_TESTS:
+            if (rules.validationPasses(run.debugAttempts, draw)) {
+                run.phase = ProgramPhase::RESEARCH_CYCLE;
+                run.debugAttempts = 0;
+            } else {
+                run.phase = ProgramPhase::DEBUGGING;
+            }
+            if (rules.debugExhausted(run.debugAttempts)) run.phase = ProgramPhase::STALLED_UNRECOVERABLE;
+            break;
+        case ProgramPhase::FINAL_ANALYSIS:
+            run.phase = ProgramPhase::QUESTION_ANSWERING;
+            break;
+        default:
+            run.phase = ProgramPhase::COMPLETE;
+            break;
+    }
+}
+
+struct SimulationOptions {
+    uint64_t trajectories = 1000000;
+    uint64_t seed = 1;
+    int maxIterations = 10000; // runs still going after this many count as unfinished
+};
+
+struct SimulationReport {
+    uint64_t trajectories = 0;
+    uint64_t completed = 0; // reached QUESTION_ANSWERING
+    uint64_t stalled = 0;   // reached STALLED_UNRECOVERABLE
+    uint64_t unfinished = 0;
+    // completedAt[n]: completed runs that took n iterations.
+    std::vector<uint64_t> completedAt;
+
+    void merge(const SimulationReport& other) {
+        trajectories += other.trajectories;
+        completed += other.completed;
+        stalled += other.stalled;
+        unfinished += other.unfinished;
+        if (completedAt.size() < other.completedAt.size()) completedAt.resize(other.completedAt.size(), 0);
+        for (size_t i = 0; i < other.completedAt.size(); ++i) completedAt[i] += other.completedAt[i];
+    }
+
+    double stallProbability() const { return trajectories ? static_cast<double>(stalled) / static_cast<double>(trajectories) : 0.0; }
+
+    double meanIterations() const {
+        if (completed == 0) return 0.0;
+        double total = 0.0;
+        for (size_t i = 0; i < completedAt.size(); ++i) total += static_cast<double>(i) * static_cast<double>(completedAt[i]);
+        return total / static_cast<double>(completed);
+    }
+
+    // Iterations within which a fraction `q` of completed runs finished;
+    // -1 when none completed.
+    int iterationsPercentile(double q) const {
+        if (completed == 0) return -1;
+        uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(completed))));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < completedAt.size(); ++i) {
+            seen += completedAt[i];
+            if (seen >= target) return static_cast<int>(i);
+        }
+        return static_cast<int>(completedAt.size()) - 1;
+    }
+};
+
+// Runs trajectories of the phase state machine on a work-stealing pool.
+// Trajectories are dealt out in fixed chunks, each with its own stream
+// seeded from (seed, chunk), and the reports only add counts, so a result
+// depends on the seed and trajectory count but not on the thread count or
+// scheduling. The streams are not std::mt19937, so a simulated trajectory
+// does not replay an orchestrator run with the same --seed.
+class PhaseSimulator {
+public:
+    explicit PhaseSimulator(size_t threads) : pool(threads) {}
+
+    size_t threads() const { return pool.size(); }
+
+    SimulationReport run(const SimulationParameters& parameters, const SimulationOptions& options) {
+        SimulationReport total;
+        std::mutex totalMutex;
+        uint64_t chunks = (options.trajectories + kChunk - 1) / kChunk;
+        pool.parallelFor(static_cast<size_t>(chunks), [&](size_t chunk) {
+            UniformBlockStream draw(options.seed ^ (0x9e3779b97f4a7c15ull * (chunk + 1)));
+            SimulationReport partial;
+            uint64_t first = chunk * kChunk;
+            partial.trajectories = std::min<uint64_t>(kChunk, options.trajectories - first);
+            for (uint64_t i = 0; i < partial.trajectories; ++i) {
+                SimulatedRun run;
+                while (!run.finished() && run.iteration < options.maxIterations) simulateIteration(parameters, run, draw);
+                if (run.phase == ProgramPhase::QUESTION_ANSWERING) {
+                    if (partial.completedAt.size() <= static_cast<size_t>(run.iteration)) partial.completedAt.resize(run.iteration + 1, 0);
+                    partial.completedAt[run.iteration]++;
+                    partial.completed++;
+                } else if (run.phase == ProgramPhase::STALLED_UNRECOVERABLE) {
+                    partial.stalled++;
+                } else {
+                    partial.unfinished++;
+                }
+            }
+            std::lock_guard<std::mutex> lock(totalMutex);
+            total.merge(partial);
+        });
+        return total;
+    }
+
+private:
+    static constexpr uint64_t kChunk = 4096;
+    WorkStealingPool pool;
+};
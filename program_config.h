@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "research_topic.h"
+
+// Reads a whole file into `contents`, reusing its capacity.
+inline bool readFile(const std::string& path, std::string& contents) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    contents.clear();
+    off_t size = ::lseek(fd, 0, SEEK_END);
+    if (size > 0) contents.reserve(static_cast<size_t>(size));
+    ::lseek(fd, 0, SEEK_SET);
+    char chunk[64 * 1024];
+    ssize_t got;
+    while ((got = ::read(fd, chunk, sizeof(chunk))) != 0) {
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            return false;
+        }
+        contents.append(chunk, static_cast<size_t>(got));
+    }
+    ::close(fd);
+    return true;
+}
+
+// Makes a rename into `path`'s directory durable.
+inline void syncParentDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd >= 0) {
+        ::fsync(dirFd);
+        ::close(dirFd);
+    }
+}
+
+// Replaces `path` with `data` so that readers (and a crash at any point) see
+// either the old or the new contents: write a sibling temp file, fsync it,
+// rename it over the target, then fsync the directory.
+inline bool writeFileAtomically(const std::string& path, std::string_view data) {
+    std::string temp = path + ".tmp";
+    int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    const char* cursor = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, cursor, remaining);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            ::close(fd);
+            ::unlink(temp.c_str());
+            return false;
+        }
+        cursor += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    if (::fsync(fd) != 0 || ::close(fd) != 0 || std::rename(temp.c_str(), path.c_str()) != 0) {
+        ::unlink(temp.c_str());
+        return false;
+    }
+    syncParentDirectory(path);
+    return true;
+}
+
+enum class ProgramPhase {
+    INITIAL_SETUP,
+    RESEARCH_CYCLE,
+    LLM_INTEGRATION,
+    DEBUGGING,
+    VALIDATION_TESTS,
+    FINAL_ANALYSIS,
+    QUESTION_ANSWERING,
+    COMPLETE,
+    STALLED_UNRECOVERABLE
+};
+
+constexpr size_t kPhaseCount = static_cast<size_t>(ProgramPhase::STALLED_UNRECOVERABLE) + 1;
+
+inline const char* phaseToString(ProgramPhase phase) {
+    switch (phase) {
+        case ProgramPhase::INITIAL_SETUP: return "INITIAL_SETUP";
+        case ProgramPhase::RESEARCH_CYCLE: return "RESEARCH_CYCLE";
+        case ProgramPhase::LLM_INTEGRATION: return "LLM_INTEGRATION";
+        case ProgramPhase::DEBUGGING: return "DEBUGGING";
+        case ProgramPhase::VALIDATION_TESTS: return "VALIDATION_TESTS";
+        case ProgramPhase::FINAL_ANALYSIS: return "FINAL_ANALYSIS";
+        case ProgramPhase::QUESTION_ANSWERING: return "QUESTION_ANSWERING";
+        case ProgramPhase::COMPLETE: return "COMPLETE";
+        case ProgramPhase::STALLED_UNRECOVERABLE: return "STALLED_UNRECOVERABLE";
+    }
+    return "UNKNOWN";
+}
+
+inline bool phaseFromString(std::string_view name, ProgramPhase& phase) {
+    static const ProgramPhase phases[] = {
+        ProgramPhase::INITIAL_SETUP, ProgramPhase::RESEARCH_CYCLE, ProgramPhase::LLM_INTEGRATION,
+        ProgramPhase::DEBUGGING, ProgramPhase::VALIDATION_TESTS, ProgramPhase::FINAL_ANALYSIS,
+        ProgramPhase::QUESTION_ANSWERING, ProgramPhase::COMPLETE, ProgramPhase::STALLED_UNRECOVERABLE
+    };
+    for (ProgramPhase candidate : phases) {
+        if (name == phaseToString(candidate)) {
+            phase = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One occurrence of the error signature found while DEBUGGING: a path
+// relative to the scanned root, a 1-based line and the line's text.
+struct DebugMatch {
+    std::string file;
+    uint32_t line = 0;
+    std::string context;
+
+    bool operator==(const DebugMatch& other) const { return line == other.line && file == other.file && context == other.context; }
+    bool operator!=(const DebugMatch& other) const { return !(*this == other); }
+};
+
+// One validation unit's outcome in the latest VALIDATION_TESTS run.
+struct ValidationRecord {
+    std::string unit;
+    std::string status; // passed, cached, failed, timed_out, cancelled or skipped
+    int64_t elapsedMs = 0;
+
+    bool operator==(const ValidationRecord& other) const { return elapsedMs == other.elapsedMs && unit == other.unit && status == other.status; }
+    bool operator!=(const ValidationRecord& other) const { return !(*this == other); }
+};
+
+struct ProgramConfig {
+    ResearchTopic researchTopic;
+    int researchIteration;
+    bool researchComplete;
+    std::string lastResearchSummary;
+    std::string lastErrorMessage;
+    bool llama3SimulatedDownloaded;
+    ProgramPhase currentPhase;
+    int debugAttempts;
+    double researchCompletenessScore;
+    std::vector<DebugMatch> debugMatches; // from the latest DEBUGGING scan
+    std::vector<ValidationRecord> validationResults; // from the latest VALIDATION_TESTS run
+
+    ProgramConfig() : researchIteration(0),
+                      researchComplete(false), lastResearchSummary("No research done yet."),
+                      lastErrorMessage("None"), llama3SimulatedDownloaded(false),
+                      currentPhase(ProgramPhase::INITIAL_SETUP), debugAttempts(0),
+                      researchCompletenessScore(0.0) {}
+
+    bool load(const std::string& filename) {
+        std::string contents;
+        if (!readFile(filename, contents)) {
+            std::cerr << "Warning: Configuration file '" << filename << "' not found. Using default settings." << std::endl;
+            return false;
+        }
+
+        JsonDocument doc;
+        if (!doc.parse(contents) || !doc.root().isObject()) {
+            std::cerr << "Warning: Configuration file '" << filename << "' is not a valid JSON object (" << doc.error() << "). Using default settings." << std::endl;
+            return false;
+        }
+        fromJson(doc.root());
+        return true;
+    }
+
+    void fromJson(JsonRef data) {
+        // "topicLineage" supersedes the legacy prefixed string when present.
+        if (JsonRef v = data["topicLineage"]) researchTopic.read(v);
+        else if (JsonRef v = data["researchTopic"]) researchTopic = ResearchTopic::fromLegacy(v.asString());
+        if (JsonRef v = data["researchIteration"]) researchIteration = static_cast<int>(v.asInt(researchIteration));
+        if (JsonRef v = data["researchComplete"]) researchComplete = v.asBool();
+        if (JsonRef v = data["lastResearchSummary"]) lastResearchSummary = std::string(v.asString());
+        if (JsonRef v = data["lastErrorMessage"]) lastErrorMessage = std::string(v.asString());
+        if (JsonRef v = data["llama3SimulatedDownloaded"]) llama3SimulatedDownloaded = v.asBool();
+        if (JsonRef v = data["debugAttempts"]) debugAttempts = static_cast<int>(v.asInt(debugAttempts));
+        if (JsonRef v = data["researchCompletenessScore"]) researchCompletenessScore = v.asNumber(researchCompletenessScore);
+        if (JsonRef v = data["currentPhase"]) phaseFromString(v.asString(), currentPhase);
+        if (JsonRef v = data["debugMatches"]) readDebugMatches(v, debugMatches);
+        if (JsonRef v = data["validationResults"]) readValidationResults(v, validationResults);
+    }
+
+    void writeFields(JsonWriter& writer) const {
+        writer.member("currentPhase", phaseToString(currentPhase));
+        writer.member("debugAttempts", debugAttempts);
+        writer.key("debugMatches");
+        writeDebugMatches(writer, debugMatches);
+        writer.member("lastErrorMessage", lastErrorMessage);
+        writer.member("lastResearchSummary", lastResearchSummary);
+        writer.member("llama3SimulatedDownloaded", llama3SimulatedDownloaded);
+        writer.member("researchComplete", researchComplete);
+        writer.member("researchCompletenessScore", researchCompletenessScore);
+        writer.member("researchIteration", researchIteration);
+        writer.member("researchTopic", researchTopic.legacy());
+        writer.key("topicLineage");
+        researchTopic.write(writer);
+        writer.key("validationResults");
+        writeValidationResults(writer, validationResults);
+    }
+
+    static void writeDebugMatches(JsonWriter& writer, const std::vector<DebugMatch>& matches) {
+        writer.beginArray();
+        for (const DebugMatch& match : matches) {
+            writer.beginObject();
+            writer.member("file", match.file);
+            writer.member("line", match.line);
+            writer.member("context", match.context);
+            writer.endObject();
+        }
+        writer.endArray();
+    }
+
+    static void readDebugMatches(JsonRef data, std::vector<DebugMatch>& matches) {
+        matches.clear();
+        data.forEachElement([&](JsonRef entry) {
+            DebugMatch match;
+            match.file.assign(entry["file"].asString());
+            match.line = static_cast<uint32_t>(std::max(0LL, entry["line"].asInt(0)));
+            match.context.assign(entry["context"].asString());
+            matches.push_back(std::move(match));
+        });
+    }
+
+    static void writeValidationResults(JsonWriter& writer, const std::vector<ValidationRecord>& records) {
+        writer.beginArray();
+        for (const ValidationRecord& record : records) {
+            writer.beginObject();
+            writer.member("unit", record.unit);
+            writer.member("status", record.status);
+            writer.member("elapsedMs", record.elapsedMs);
+            writer.endObject();
+        }
+        writer.endArray();
+    }
+
+    static void readValidationResults(JsonRef data, std::vector<ValidationRecord>& records) {
+        records.clear();
+        data.forEachElement([&](JsonRef entry) {
+            ValidationRecord record;
+            record.unit.assign(entry["unit"].asString());
+            record.status.assign(entry["status"].asString());
+            record.elapsedMs = entry["elapsedMs"].asInt(0);
+            records.push_back(std::move(record));
+        });
+    }
+
+    void toJson(std::string& out) const {
+        JsonWriter writer(out);
+        writer.beginObject();
+        writeFields(writer);
+        writer.endObject();
+    }
+
+    bool save(const std::string& filename) const {
+        static thread_local std::string buffer;
+        buffer.clear();
+        toJson(buffer);
+        if (!writeFileAtomically(filename, buffer)) {
+            std::cerr << "Error: Could not write configuration file '" << filename << "'." << std::endl;
+            return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,542 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "knowledge_base.h"
+#include "program_config.h"
+#include "research_session.h"
+
+struct QuestionServerOptions {
+    size_t workers = 4;
+    size_t answerPassages = 3;
+    size_t maxPipelined = 256;       // unanswered questions per connection before reading pauses
+    size_t maxLineBytes = 64 << 10;  // longest accepted question
+};
+
+// Answers questions about a concluded research run, replacing the one-user
+// getline loop for anything non-interactive.
+//
+// The protocol is line based: each newline-terminated line a client sends
+// is one question, and each answer comes back as one JSON line
+//
+//   {"id": 0, "question": "...", "answer": "...", "topic": "...",
+//    "completeness": 100, "passages": [{"iteration", "topic", "score",
+//    "text"}, ...], "retrievalUs": 12}
+//
+// where "id" numbers the questions on that connection from 0. Clients may
+// pipeline as many questions as they like; answers always come back in
+// question order. A question longer than maxLineBytes is answered with
+// {"id": n, "error": "..."} and the connection is closed.
+//
+// One thread runs an epoll loop over the listening socket and every
+// connection; a worker pool searches the knowledge base and formats the
+// answers. Workers share the loaded KnowledgeBase and ProgramConfig by const
+// reference (each keeps its own search scratch), so neither may change
+// while the server runs.
+class QuestionServer {
+public:
+    QuestionServer(const KnowledgeBase& knowledgeBase, const ProgramConfig& programConfig, const QuestionServerOptions& serverOptions,
+                   OrchestratorMetrics& sharedMetrics)
+        : knowledge(knowledgeBase), config(programConfig), options(serverOptions), metrics(sharedMetrics) {
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    ~QuestionServer() {
+        stopWorkers();
+        for (auto& entry : connections) ::close(entry.second->fd);
+        if (listenFd >= 0) ::close(listenFd);
+        if (epollFd >= 0) ::close(epollFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+    }
+
+    QuestionServer(const QuestionServer&) = delete;
+    QuestionServer& operator=(const QuestionServer&) = delete;
+
+    // Binds a Unix stream socket at `socketPath`, replacing a stale one.
+    bool listen(const std::string& socketPath) {
+        sockaddr_un address{};
+        if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+            std::cerr << "Error: Socket path '" << socketPath << "' is empty or too long." << std::endl;
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0) {
+            std::cerr << "Error: Could not create a Unix socket." << std::endl;
+            return false;
+        }
+        ::unlink(socketPath.c_str());
+        if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || ::listen(listenFd, SOMAXCONN) != 0) {
+            std::cerr << "Error: Could not listen on '" << socketPath << "' (errno " << errno << ")." << std::endl;
+            ::close(listenFd);
+            listenFd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // Serves connections until requestStop(). Returns false if the event
+    // loop could not be set up or failed.
+    bool serve() {
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (listenFd < 0 || wakeFd < 0 || epollFd < 0) {
+            std::cerr << "Error: Could not set up the question server event loop." << std::endl;
+            return false;
+        }
+        watch(listenFd, kListenToken, EPOLLIN, EPOLL_CTL_ADD);
+        watch(wakeFd, kWakeToken, EPOLLIN, EPOLL_CTL_ADD);
+        startWorkers();
+
+        bool healthy = true;
+        std::vector<epoll_event> events(256);
+        while (!stopRequested.load(std::memory_order_relaxed)) {
+            int ready = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), -1);
+            if (ready < 0) {
+                if (errno == EINTR) continue;
+                std::cerr << "Error: Question server event loop failed (epoll_wait errno " << errno << ")." << std::endl;
+                healthy = false;
+                break;
+            }
+            for (int i = 0; i < ready; ++i) {
+                uint64_t token = events[i].data.u64;
+                if (token == kWakeToken) {
+                    drainWake();
+                    deliverCompletions();
+                } else if (token == kListenToken) {
+                    acceptConnections();
+                } else {
+                    auto found = connections.find(token);
+                    if (found == connections.end()) continue;
+                    Connection& connection = *found->second;
+                    if (events[i].events & (EPOLLHUP | EPOLLERR)) connection.broken = true;
+                    else if (events[i].events & EPOLLIN) readFrom(connection);
+                    if (!connection.broken && (events[i].events & EPOLLOUT)) writeTo(connection);
+                    finishIfDone(connection);
+                }
+            }
+        }
+        stopWorkers();
+        for (auto& entry : connections) ::close(entry.second->fd);
+        connections.clear();
+        return healthy;
+    }
+
+    // Makes serve() return. Async-signal-safe.
+    void requestStop() {
+        stopRequested.store(true, std::memory_order_relaxed);
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+
+    // Answers every non-empty line of `inputFd` as JSON lines on `outputFd`,
+    // in order, keeping at most maxPipelined questions in flight per worker.
+    // An oversized line is answered with an error and ends the batch.
+    // Returns the number of lines answered, or -1 on a read or write error.
+    long long answerBatch(int inputFd, int outputFd) {
+        if (wakeFd < 0) return -1;
+        startWorkers();
+        Connection batch;
+        batch.id = kBatchToken;
+        batch.fd = outputFd;
+        size_t window = options.maxPipelined * std::max<size_t>(1, options.workers);
+        std::string chunk(kReadChunk, '\0');
+        bool endOfInput = false;
+        bool failed = false;
+        for (;;) {
+            deliverCompletions(&batch);
+            if (!writeAll(outputFd, batch)) {
+                std::cerr << "Error: Could not write batch answers." << std::endl;
+                failed = true;
+                break;
+            }
+            if (endOfInput && batch.nextToSend == batch.nextSequence) break;
+            if (!endOfInput && batch.nextSequence - batch.nextToSend < window) {
+                ssize_t got = ::read(inputFd, &chunk[0], chunk.size());
+                if (got < 0 && errno == EINTR) continue;
+                if (got < 0) {
+                    std::cerr << "Error: Could not read the question batch." << std::endl;
+                    failed = true;
+                    break;
+                }
+                if (got == 0) {
+                    endOfInput = true;
+                    if (!batch.input.empty()) batch.input.push_back('\n');
+                } else {
+                    batch.input.append(chunk.data(), static_cast<size_t>(got));
+                }
+                submitLines(batch, window);
+                if (batch.closing) endOfInput = true;
+                continue;
+            }
+            pollfd wait{wakeFd, POLLIN, 0};
+            ::poll(&wait, 1, -1);
+            drainWake();
+        }
+        stopWorkers();
+        return failed ? -1 : static_cast<long long>(batch.nextToSend);
+    }
+
+    size_t connectionCount() const { return connections.size(); }
+
+private:
+    static constexpr uint64_t kWakeToken = 0;
+    static constexpr uint64_t kListenToken = 1;
+    static constexpr uint64_t kBatchToken = 2;
+    static constexpr size_t kReadChunk = 64 << 10;
+    static constexpr size_t kJobsPerGrab = 16;
+
+    struct Job {
+        uint64_t connection;
+        uint64_t sequence;
+        SteadyClock::time_point received;
+        std::string question;
+    };
+
+    struct Completion {
+        uint64_t connection;
+        uint64_t sequence;
+        SteadyClock::time_point received;
+        std::string answer;
+    };
+
+    struct Connection {
+        uint64_t id = 0;
+        int fd = -1;
+        std::string input;
+        std::string output;
+        size_t outputSent = 0;
+        uint64_t nextSequence = 0;  // id of the next question read
+        uint64_t nextToSend = 0;    // id of the next answer owed
+        std::map<uint64_t, Completion> early;  // answered ahead of nextToSend
+        uint32_t events = 0;
+        bool peerClosed = false;    // end of input; answers are still owed
+        bool closing = false;       // stop reading; close once the output drains
+        bool broken = false;        // hung up or unwritable; close now
+    };
+
+    void watch(int fd, uint64_t token, uint32_t events, int operation) {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = token;
+        ::epoll_ctl(epollFd, operation, fd, &event);
+    }
+
+    void drainWake() {
+        uint64_t ignored;
+        while (::read(wakeFd, &ignored, sizeof(ignored)) > 0) {}
+    }
+
+    void acceptConnections() {
+        for (;;) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK) std::cerr << "Warning: Question server accept failed (errno " << errno << ")." << std::endl;
+                return;
+            }
+            auto connection = std::make_unique<Connection>();
+            connection->id = nextConnectionId++;
+            connection->fd = fd;
+            connection->events = EPOLLIN;
+            watch(fd, connection->id, connection->events, EPOLL_CTL_ADD);
+            connections.emplace(connection->id, std::move(connection));
+        }
+    }
+
+    void readFrom(Connection& connection) {
+        if (connection.closing || connection.peerClosed) return;
+        size_t limit = options.maxPipelined;
+        while (connection.nextSequence - connection.nextToSend < limit && !connection.closing) {
+            readBuffer.resize(kReadChunk);
+            ssize_t got = ::recv(connection.fd, readBuffer.data(), readBuffer.size(), 0);
+            if (got > 0) connection.input.append(readBuffer.data(), static_cast<size_t>(got));
+            if (got < 0 && errno == EINTR) continue;
+            if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (got <= 0) {
+                // A client may half-close after its last question; an
+                // unterminated final line still counts.
+                connection.peerClosed = true;
+                if (!connection.input.empty()) connection.input.push_back('\n');
+            }
+            submitLines(connection, limit);
+            if (connection.peerClosed) break;
+        }
+        updateInterest(connection);
+    }
+
+    // Queues every complete line of `connection.input`, up to `limit`
+    // unanswered questions; whatever is left stays buffered.
+    void submitLines(Connection& connection, size_t limit) {
+        std::vector<Job> batch;
+        size_t start = 0;
+        bool oversized = false;
+        auto now = SteadyClock::now();
+        while (connection.nextSequence - connection.nextToSend < limit) {
+            size_t newline = connection.input.find('\n', start);
+            size_t end = newline == std::string::npos ? connection.input.size() : newline;
+            if (end > start && connection.input[end - 1] == '\r') --end;
+            if (end - start > options.maxLineBytes) {
+                oversized = true;
+                break;
+            }
+            if (newline == std::string::npos) break;
+            if (end > start) batch.push_back(Job{connection.id, connection.nextSequence++, now, connection.input.substr(start, end - start)});
+            start = newline + 1;
+        }
+        connection.input.erase(0, start);
+        if (!batch.empty()) {
+            {
+                std::lock_guard<std::mutex> lock(jobMutex);
+                for (Job& job : batch) jobs.push_back(std::move(job));
+            }
+            if (batch.size() == 1) jobReady.notify_one();
+            else jobReady.notify_all();
+        }
+        if (oversized) rejectOversized(connection);
+    }
+
+    void rejectOversized(Connection& connection) {
+        std::string line;
+        JsonWriter writer(line, false);
+        writer.beginObject();
+        writer.member("id", connection.nextSequence);
+        writer.member("error", "question exceeds " + std::to_string(options.maxLineBytes) + " bytes");
+        writer.endObject();
+        line.push_back('\n');
+        uint64_t sequence = connection.nextSequence++;
+        connection.early.emplace(sequence, Completion{connection.id, sequence, SteadyClock::now(), std::move(line)});
+        connection.input.clear();
+        connection.closing = true;
+        release(connection);
+    }
+
+    // Moves answers that are next in order from `early` to the output.
+    void release(Connection& connection) {
+        auto now = SteadyClock::now();
+        for (auto next = connection.early.begin(); next != connection.early.end() && next->first == connection.nextToSend;
+             next = connection.early.erase(next)) {
+            connection.output += next->second.answer;
+            ++connection.nextToSend;
+            metrics.questions.increment();
+            metrics.questionLatency.record(now - next->second.received);
+        }
+    }
+
+    void deliverCompletions(Connection* batch = nullptr) {
+        std::vector<Completion> done;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            done.swap(completed);
+        }
+        std::vector<Connection*> touched;
+        for (Completion& completion : done) {
+            Connection* connection = batch;
+            if (!connection) {
+                auto found = connections.find(completion.connection);
+                if (found == connections.end()) continue;  // client went away
+                connection = found->second.get();
+            }
+            uint64_t sequence = completion.sequence;
+            connection->early.emplace(sequence, std::move(completion));
+            if (std::find(touched.begin(), touched.end(), connection) == touched.end()) touched.push_back(connection);
+        }
+        for (Connection* connection : touched) {
+            release(*connection);
+            if (batch || connection->broken) continue;
+            writeTo(*connection);
+            // Questions held back by the pipelining limit can go now.
+            if (!connection->closing && !connection->broken) submitLines(*connection, options.maxPipelined);
+            updateInterest(*connection);
+            finishIfDone(*connection);
+        }
+    }
+
+    void writeTo(Connection& connection) {
+        while (connection.outputSent < connection.output.size()) {
+            ssize_t sent = ::send(connection.fd, connection.output.data() + connection.outputSent, connection.output.size() - connection.outputSent,
+                                  MSG_NOSIGNAL);
+            if (sent < 0 && errno == EINTR) continue;
+            if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+            if (sent <= 0) {
+                connection.broken = true;
+                return;
+            }
+            connection.outputSent += static_cast<size_t>(sent);
+        }
+        if (connection.outputSent == connection.output.size()) {
+            connection.output.clear();
+            connection.outputSent = 0;
+        } else if (connection.outputSent > (1u << 20)) {
+            connection.output.erase(0, connection.outputSent);
+            connection.outputSent = 0;
+        }
+        updateInterest(connection);
+    }
+
+    static bool writeAll(int fd, Connection& batch) {
+        while (batch.outputSent < batch.output.size()) {
+            ssize_t wrote = ::write(fd, batch.output.data() + batch.outputSent, batch.output.size() - batch.outputSent);
+            if (wrote < 0 && errno == EINTR) continue;
+            if (wrote <= 0) return false;
+            batch.outputSent += static_cast<size_t>(wrote);
+        }
+        batch.output.clear();
+        batch.outputSent = 0;
+        return true;
+    }
+
+    void updateInterest(Connection& connection) {
+        uint32_t wanted = 0;
+        if (connection.broken) return;
+        if (!connection.closing && !connection.peerClosed && connection.nextSequence - connection.nextToSend < options.maxPipelined) wanted |= EPOLLIN;
+        if (connection.outputSent < connection.output.size()) wanted |= EPOLLOUT;
+        if (wanted == connection.events) return;
+        connection.events = wanted;
+        watch(connection.fd, connection.id, wanted, EPOLL_CTL_MOD);
+    }
+
+    // Closes a connection once it can send nothing more.
+    void finishIfDone(Connection& connection) {
+        bool finished = (connection.peerClosed || connection.closing) && connection.nextToSend == connection.nextSequence && connection.output.empty();
+        if (!connection.broken && !finished) return;
+        ::epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        ::close(connection.fd);
+        connections.erase(connection.id);
+    }
+
+    void startWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = false;
+        }
+        size_t count = std::max<size_t>(1, options.workers);
+        while (workers.size() < count) workers.emplace_back([this] { workerLoop(); });
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(jobMutex);
+            stopping = true;
+            jobs.clear();
+        }
+        jobReady.notify_all();
+        for (std::thread& worker : workers) worker.join();
+        workers.clear();
+    }
+
+    void workerLoop() {
+        KnowledgeSearchScratch scratch;
+        std::vector<KnowledgeHit> hits;
+        std::vector<Job> taken;
+        std::vector<Completion> done;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(jobMutex);
+                jobReady.wait(lock, [&] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                // Take a fair share so one pipelined client cannot starve the pool.
+                size_t share = std::min(kJobsPerGrab, std::max<size_t>(1, jobs.size() / std::max<size_t>(1, options.workers)));
+                for (size_t i = 0; i < share; ++i) {
+                    taken.push_back(std::move(jobs.front()));
+                    jobs.pop_front();
+                }
+            }
+            for (Job& job : taken) {
+                done.push_back(Completion{job.connection, job.sequence, job.received, {}});
+                answer(job, scratch, hits, done.back().answer);
+            }
+            taken.clear();
+            bool wasEmpty;
+            {
+                std::lock_guard<std::mutex> lock(completionMutex);
+                wasEmpty = completed.empty();
+                for (Completion& completion : done) completed.push_back(std::move(completion));
+            }
+            done.clear();
+            if (wasEmpty) {
+                uint64_t one = 1;
+                ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+                (void)ignored;
+            }
+        }
+    }
+
+    void answer(const Job& job, KnowledgeSearchScratch& scratch, std::vector<KnowledgeHit>& hits, std::string& out) const {
+        auto started = SteadyClock::now();
+        knowledge.search(job.question, options.answerPassages, hits, scratch);
+        auto elapsed = SteadyClock::now() - started;
+        metrics.knowledgeSearch.record(elapsed);
+
+        JsonWriter writer(out, false);
+        writer.beginObject();
+        writer.member("id", job.sequence);
+        writer.member("question", job.question);
+        writer.member("answer", hits.empty() ? config.lastResearchSummary : hits.front().text);
+        writer.member("topic", config.researchTopic.base());
+        writer.member("completeness", config.researchCompletenessScore);
+        writer.key("passages");
+        writer.beginArray();
+        for (const KnowledgeHit& hit : hits) {
+            writer.beginObject();
+            writer.member("iteration", hit.iteration);
+            writer.member("topic", hit.topic);
+            writer.member("score", hit.score);
+            writer.member("text", hit.text);
+            writer.endObject();
+        }
+        writer.endArray();
+        writer.member("retrievalUs", std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+        writer.endObject();
+        out.push_back('\n');
+    }
+
+    const KnowledgeBase& knowledge;
+    const ProgramConfig& config;
+    QuestionServerOptions options;
+    OrchestratorMetrics& metrics;
+    std::atomic<bool> stopRequested{false};
+    int wakeFd = -1;
+
+    // Loop thread only.
+    int listenFd = -1;
+    int epollFd = -1;
+    uint64_t nextConnectionId = kBatchToken + 1;
+    std::unordered_map<uint64_t, std::unique_ptr<Connection>> connections;
+    std::vector<char> readBuffer;
+
+    std::mutex jobMutex;
+    std::condition_variable jobReady;
+    std::deque<Job> jobs;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    std::mutex completionMutex;
+    std::vector<Completion> completed;
+};
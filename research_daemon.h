@@ -0,0 +1,382 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "metrics.h"
+#include "research_session.h"
+#include "result_cache.h"
+#include "subprocess.h"
+
+// Drives many independent research sessions from one process. Each session
+// is a ResearchSession state object; a small worker pool runs their
+// iterations, and one event loop thread owns everything that used to block:
+//
+//  - scripted pauses become timers (sessions use a deferred Pacer),
+//  - researcher subprocesses are launched by the loop and their pipes are
+//    multiplexed through epoll, at most `maxResearchers` at a time,
+//  - a session is only ever touched by one thread at a time.
+//
+// Sessions are isolated: each keeps its own config.json, journal and
+// knowledge base under its directory, and one reaching STALLED_UNRECOVERABLE
+// (or throwing out of a phase) just stops being scheduled. The researcher
+// result cache is shared behind a mutex. Persistent researchers, subtopic
+// fan-out, the DEBUGGING scanner and the validation runner are not used in
+// this mode.
+class ResearchDaemon {
+public:
+    ResearchDaemon(const OrchestratorOptions& orchestratorOptions, Logger& daemonLogger, MetricsRegistry& registry,
+                   OrchestratorMetrics& sharedMetrics, ResultCache* cache)
+        : options(orchestratorOptions),
+          logger(daemonLogger),
+          metrics(sharedMetrics),
+          resultCache(cache),
+          activeSessions(registry.gauge("orchestrator_daemon_sessions_active", "Sessions that have not finished")),
+          runningResearchers(registry.gauge("orchestrator_daemon_researchers_running", "Researcher processes currently running")),
+          queuedResearchers(registry.gauge("orchestrator_daemon_researchers_queued", "Sessions waiting for a researcher slot")),
+          sessionFailures(registry.counter("orchestrator_daemon_session_failures_total", "Sessions that ended in STALLED_UNRECOVERABLE")) {}
+
+    ~ResearchDaemon() { stopWorkers(); }
+
+    ResearchDaemon(const ResearchDaemon&) = delete;
+    ResearchDaemon& operator=(const ResearchDaemon&) = delete;
+
+    // Adds every subdirectory of `root` as a session named after it, in
+    // name order, seeding session i with baseSeed + i.
+    bool addSessions(const std::string& root, uint32_t baseSeed) {
+        DIR* dir = ::opendir(root.c_str());
+        if (!dir) {
+            std::cerr << "Error: Session directory '" << root << "' cannot be opened." << std::endl;
+            return false;
+        }
+        std::vector<std::string> names;
+        while (dirent* item = ::readdir(dir)) {
+            std::string name = item->d_name;
+            if (name.empty() || name[0] == '.') continue;
+            struct stat info;
+            if (::stat((root + "/" + name).c_str(), &info) == 0 && S_ISDIR(info.st_mode)) names.push_back(name);
+        }
+        ::closedir(dir);
+        if (names.empty()) {
+            std::cerr << "Error: No session directories found in '" << root << "'." << std::endl;
+            return false;
+        }
+        std::sort(names.begin(), names.end());
+        for (size_t i = 0; i < names.size(); ++i) addSession(names[i], root + "/" + names[i], baseSeed + static_cast<uint32_t>(i));
+        return true;
+    }
+
+    void addSession(const std::string& name, const std::string& directory, uint32_t seed) {
+        auto slot = std::make_unique<Slot>();
+        slot->session = std::make_unique<ResearchSession>(name, directory, options, logger, metrics, seed);
+        if (!slot->session->openState()) {
+            // Not scheduled: running from default state with persistence off
+            // could later overwrite the snapshot that failed to load.
+            slot->session->fail("State journal '" + slot->session->journal().journalFile() + "' cannot be opened or read; the session was not run");
+            sessionFailures.increment();
+            slots.push_back(std::move(slot));
+            return;
+        }
+        slot->session->openKnowledge();
+        slot->session->useResultCache(resultCache, &cacheMutex);
+        slot->session->pacer().setDeferred(true);
+        slots.push_back(std::move(slot));
+    }
+
+    // Runs every session until it finishes; returns how many stalled.
+    int run() {
+        Logger::setSession(nullptr);
+        Logger::setContext(-1, nullptr);
+        if (options.persistentResearcher) {
+            logger.warning() << "Warning: --persistent-researcher is ignored in daemon mode; researchers run one-shot.";
+        }
+        if (options.fanout > 1) {
+            logger.warning() << "Warning: --fanout is ignored in daemon mode; each session makes one researcher call per cycle.";
+        }
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (wakeFd < 0 || epollFd < 0) {
+            logger.error() << "Error: Could not set up the daemon event loop.";
+            return static_cast<int>(slots.size());
+        }
+        epoll_event wakeEvent{};
+        wakeEvent.events = EPOLLIN;
+        wakeEvent.data.u64 = kWakeToken;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &wakeEvent);
+
+        size_t workerCount = std::max<size_t>(1, options.daemonWorkers);
+        logger.info() << "[ORCHESTRATOR]: Daemon driving " << slots.size() << " sessions with " << workerCount << " workers and at most "
+                      << std::max<size_t>(1, options.maxResearchers) << " concurrent researchers. Pacing: " << options.pacer.describe();
+        for (size_t i = 0; i < workerCount; ++i) workers.emplace_back([this] { workerLoop(); });
+
+        size_t finished = 0;
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (slots[i]->session->finished()) ++finished;
+            else dispatch(i);
+        }
+        activeSessions.set(static_cast<double>(slots.size() - finished));
+
+        std::vector<epoll_event> events(64);
+        while (finished < slots.size()) {
+            launchResearchers();
+            int ready = ::epoll_wait(epollFd, events.data(), static_cast<int>(events.size()), nextTimeoutMs());
+            if (ready < 0 && errno != EINTR) {
+                logger.error() << "Error: Daemon event loop failed (epoll_wait errno " << errno << ").";
+                break;
+            }
+            for (int i = 0; i < ready; ++i) {
+                uint64_t token = events[i].data.u64;
+                if (token == kWakeToken) {
+                    uint64_t ignored;
+                    while (::read(wakeFd, &ignored, sizeof(ignored)) > 0) {}
+                    continue;
+                }
+                size_t index = static_cast<size_t>(token >> 1);
+                Slot& slot = *slots[index];
+                slot.child.readReady((token & 1) ? slot.child.errorFd() : slot.child.outputFd());
+            }
+            finished += collectCompletions();
+            fireTimers();
+            checkResearchers();
+            activeSessions.set(static_cast<double>(slots.size() - finished));
+        }
+
+        stopWorkers();
+        ::close(epollFd);
+        ::close(wakeFd);
+        epollFd = wakeFd = -1;
+        return report();
+    }
+
+    size_t sessionCount() const { return slots.size(); }
+    const ResearchSession& session(size_t index) const { return *slots[index]->session; }
+
+private:
+    static constexpr uint64_t kWakeToken = ~0ull;
+
+    struct Slot {
+        std::unique_ptr<ResearchSession> session;
+        bool finishResearch = false;   // next worker step completes a researcher call
+        bool wantsResearcher = false;  // set by the worker: argv holds a researcher call
+        std::chrono::microseconds delay{0};
+        std::vector<std::string> argv;
+        AsyncSubprocess child;
+        SubprocessResult run;
+        SteadyClock::time_point deadline;
+    };
+
+    using Timer = std::pair<SteadyClock::time_point, size_t>;
+
+    void workerLoop() {
+        for (;;) {
+            size_t index;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&] { return stopping || !readyQueue.empty(); });
+                if (readyQueue.empty()) return;
+                index = readyQueue.front();
+                readyQueue.pop_front();
+            }
+            Slot& slot = *slots[index];
+            ResearchSession& session = *slot.session;
+            slot.wantsResearcher = false;
+            try {
+                if (slot.finishResearch) {
+                    slot.finishResearch = false;
+                    session.finishResearch(slot.run);
+                } else {
+                    slot.wantsResearcher = session.startIteration(slot.argv);
+                }
+            } catch (const std::exception& error) {
+                slot.wantsResearcher = false;
+                session.fail(std::string("Session aborted by an internal error: ") + error.what());
+            }
+            if (session.finished()) session.compact();
+            slot.delay = session.pacer().takeDeferred();
+            {
+                std::lock_guard<std::mutex> lock(completionMutex);
+                completed.push_back(index);
+            }
+            uint64_t one = 1;
+            ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            stopping = true;
+        }
+        queueReady.notify_all();
+        for (std::thread& worker : workers) worker.join();
+        workers.clear();
+    }
+
+    // Sends a session to its next stage now that nothing is holding it.
+    void dispatch(size_t index) {
+        Slot& slot = *slots[index];
+        if (slot.wantsResearcher) {
+            slot.wantsResearcher = false;
+            researcherQueue.push_back(index);
+            queuedResearchers.set(static_cast<double>(researcherQueue.size()));
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            readyQueue.push_back(index);
+        }
+        queueReady.notify_one();
+    }
+
+    size_t collectCompletions() {
+        std::vector<size_t> batch;
+        {
+            std::lock_guard<std::mutex> lock(completionMutex);
+            batch.swap(completed);
+        }
+        size_t finished = 0;
+        for (size_t index : batch) {
+            Slot& slot = *slots[index];
+            if (slot.session->finished()) {
+                ++finished;
+                if (slot.session->config().currentPhase == ProgramPhase::STALLED_UNRECOVERABLE) sessionFailures.increment();
+            } else if (slot.delay.count() > 0) {
+                timers.push(Timer{SteadyClock::now() + slot.delay, index});
+            } else {
+                dispatch(index);
+            }
+        }
+        return finished;
+    }
+
+    void fireTimers() {
+        auto now = SteadyClock::now();
+        while (!timers.empty() && timers.top().first <= now) {
+            size_t index = timers.top().second;
+            timers.pop();
+            dispatch(index);
+        }
+    }
+
+    void launchResearchers() {
+        size_t limit = std::max<size_t>(1, options.maxResearchers);
+        while (researching.size() < limit && !researcherQueue.empty()) {
+            size_t index = researcherQueue.front();
+            researcherQueue.pop_front();
+            Slot& slot = *slots[index];
+            if (!slot.child.start(slot.argv, slot.run)) {
+                slot.finishResearch = true;
+                dispatch(index);
+                continue;
+            }
+            slot.deadline = deadlineAfter(options.researcherTimeout);
+            for (uint64_t stream = 0; stream < 2; ++stream) {
+                epoll_event event{};
+                event.events = EPOLLIN;
+                event.data.u64 = (static_cast<uint64_t>(index) << 1) | stream;
+                ::epoll_ctl(epollFd, EPOLL_CTL_ADD, stream ? slot.child.errorFd() : slot.child.outputFd(), &event);
+            }
+            researching.push_back(index);
+        }
+        queuedResearchers.set(static_cast<double>(researcherQueue.size()));
+        runningResearchers.set(static_cast<double>(researching.size()));
+    }
+
+    // Reaps researchers whose pipes have closed and kills those past their deadline.
+    void checkResearchers() {
+        auto now = SteadyClock::now();
+        for (size_t i = 0; i < researching.size();) {
+            size_t index = researching[i];
+            Slot& slot = *slots[index];
+            if (now >= slot.deadline) slot.child.kill();
+            if ((!slot.child.pipesOpen() || slot.run.timedOut) && slot.child.tryReap()) {
+                metrics.researcherCall.record(slot.run.elapsed);
+                researching[i] = researching.back();
+                researching.pop_back();
+                slot.finishResearch = true;
+                dispatch(index);
+            } else {
+                ++i;
+            }
+        }
+        runningResearchers.set(static_cast<double>(researching.size()));
+    }
+
+    int nextTimeoutMs() const {
+        auto wake = SteadyClock::time_point::max();
+        if (!timers.empty()) wake = timers.top().first;
+        for (size_t index : researching) {
+            const Slot& slot = *slots[index];
+            // A child that closed its pipes but has not exited yet is polled.
+            if (!slot.child.pipesOpen()) return 1;
+            wake = std::min(wake, slot.deadline);
+        }
+        return pollTimeoutMs(wake);
+    }
+
+    int report() {
+        Logger::setSession(nullptr);
+        Logger::setContext(-1, nullptr);
+        int stalled = 0;
+        logger.notice() << "\n--- Research Daemon Concluded ---";
+        for (const auto& slot : slots) {
+            const ProgramConfig& config = slot->session->config();
+            if (config.currentPhase == ProgramPhase::STALLED_UNRECOVERABLE) {
+                ++stalled;
+                logger.warning() << "[ORCHESTRATOR WARNING]: Session '" << slot->session->name() << "' is unrecoverable after iteration "
+                                 << config.researchIteration << ": " << config.lastErrorMessage;
+            } else {
+                logger.notice() << "[ORCHESTRATOR]: Session '" << slot->session->name() << "' reached " << phaseToString(config.currentPhase)
+                                << " after " << config.researchIteration << " iterations (completeness " << config.researchCompletenessScore << "%).";
+            }
+        }
+        logger.notice() << "[ORCHESTRATOR]: " << slots.size() - static_cast<size_t>(stalled) << " of " << slots.size() << " sessions completed.";
+        return stalled;
+    }
+
+    const OrchestratorOptions& options;
+    Logger& logger;
+    OrchestratorMetrics& metrics;
+    ResultCache* resultCache;
+    std::mutex cacheMutex;
+    Gauge& activeSessions;
+    Gauge& runningResearchers;
+    Gauge& queuedResearchers;
+    Counter& sessionFailures;
+    std::vector<std::unique_ptr<Slot>> slots;
+
+    // Loop thread only.
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+    std::deque<size_t> researcherQueue;
+    std::vector<size_t> researching;
+    int epollFd = -1;
+    int wakeFd = -1;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<size_t> readyQueue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+
+    std::mutex completionMutex;
+    std::vector<size_t> completed;
+};
@@ -0,0 +1,761 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "debug_scanner.h"
+#include "json.h"
+#include "knowledge_base.h"
+#include "logger.h"
+#include "metrics.h"
+#include "pacing.h"
+#include "phase_rules.h"
+#include "program_config.h"
+#include "research_topic.h"
+#include "researcher_worker.h"
+#include "result_cache.h"
+#include "state_journal.h"
+#include "subprocess.h"
+#include "validation_runner.h"
+#include "work_pool.h"
+
+inline void simulateTerminalTyping(Logger& logger, Pacer& pacer, const std::string& command) {
+    logger.info() << "\n=======================================================";
+    logger.info() << "[ORCHESTRATOR SIMULATING TERMINAL ACTION]: Executing command: '" << command << "'";
+    logger.info() << "=======================================================\n";
+    pacer.pause(std::chrono::seconds(1));
+}
+
+inline void simulateCodeModification(Logger& logger, Pacer& pacer, const std::string& fileName, const std::string& modificationDescription) {
+    logger.info() << "\n[ORCHESTRATOR]: Initiating self-modification protocol. Targeting '" << fileName << "' for " << modificationDescription << ".";
+    simulateTerminalTyping(logger, pacer, "vim " + fileName);
+    logger.info() << "[ORCHESTRATOR]: Analyzing code structure, identifying modification points, and auto-generating new code logic.";
+    pacer.pause(std::chrono::seconds(2));
+    logger.info() << "[ORCHESTRATOR]: Applying generated patch/new code segment for '" << fileName << "'. This involves conceptual alteration of functional behavior.";
+    pacer.pause(std::chrono::seconds(1));
+    logger.info() << "[ORCHESTRATOR]: Self-modification complete. The internal logic of the research module has been conceptually updated.";
+    simulateTerminalTyping(logger, pacer, "git diff " + fileName);
+    logger.info() << "[ORCHESTRATOR]: Reviewed conceptual code changes to ensure internal consistency and functional correctness.";
+}
+
+// Instrumentation for one orchestrator run. Every metric is registered here
+// up front; the state machine only touches the returned atomics, so sessions
+// driven from several threads can share one instance.
+struct OrchestratorMetrics {
+    explicit OrchestratorMetrics(MetricsRegistry& registry)
+        : iterations(registry.counter("orchestrator_iterations_total", "State machine iterations executed")),
+          debugAttempts(registry.counter("orchestrator_debug_attempts_total", "DEBUGGING phases entered")),
+          validationFailures(registry.counter("orchestrator_validation_failures_total", "VALIDATION_TESTS runs that failed")),
+          researcherFailures(registry.counter("orchestrator_researcher_failures_total", "Researcher calls that crashed, timed out or could not start")),
+          completeness(registry.gauge("orchestrator_research_completeness_score", "Latest researchCompletenessScore (percent)")),
+          iteration(registry.gauge("orchestrator_research_iteration", "Current researchIteration")),
+          researcherCall(io(registry, "researcher_call")),
+          researcherParse(io(registry, "researcher_parse")),
+          cacheLookup(io(registry, "cache_lookup")),
+          knowledgeAdd(io(registry, "knowledge_add")),
+          knowledgeSearch(io(registry, "knowledge_search")),
+          journalRecord(io(registry, "journal_record")),
+          journalCompact(io(registry, "journal_compact")),
+          debugScan(io(registry, "debug_scan")),
+          validationShard(io(registry, "validation_shard")),
+          questions(registry.counter("orchestrator_questions_total", "Questions answered by the question server or batch mode")),
+          questionLatency(registry.histogram("orchestrator_question_duration_seconds", "Time from reading a question to queuing its answer")) {
+        for (size_t i = 0; i < kPhaseCount; ++i) {
+            phaseDuration[i] = &registry.histogram("orchestrator_phase_duration_seconds", "Wall-clock time of one state machine iteration, by phase",
+                                                   std::string("phase=\"") + phaseToString(static_cast<ProgramPhase>(i)) + "\"");
+        }
+        for (size_t from = 0; from < kPhaseCount; ++from) {
+            for (size_t to = 0; to < kPhaseCount; ++to) {
+                transitions[from][to] = &registry.counter("orchestrator_phase_transitions_total", "Phase changes at the end of an iteration",
+                                                          std::string("from=\"") + phaseToString(static_cast<ProgramPhase>(from)) + "\",to=\"" +
+                                                              phaseToString(static_cast<ProgramPhase>(to)) + "\"");
+            }
+        }
+    }
+
+    static LatencyHistogram& io(MetricsRegistry& registry, const char* operation) {
+        return registry.histogram("orchestrator_io_duration_seconds", "Wall-clock time of I/O and parsing calls, by operation",
+                                  std::string("operation=\"") + operation + "\"");
+    }
+
+    Counter& iterations;
+    Counter& debugAttempts;
+    Counter& validationFailures;
+    Counter& researcherFailures;
+    Gauge& completeness;
+    Gauge& iteration;
+    LatencyHistogram& researcherCall;
+    LatencyHistogram& researcherParse;
+    LatencyHistogram& cacheLookup;
+    LatencyHistogram& knowledgeAdd;
+    LatencyHistogram& knowledgeSearch;
+    LatencyHistogram& journalRecord;
+    LatencyHistogram& journalCompact;
+    LatencyHistogram& debugScan;
+    LatencyHistogram& validationShard;
+    Counter& questions;
+    LatencyHistogram& questionLatency;
+    LatencyHistogram* phaseDuration[kPhaseCount];
+    Counter* transitions[kPhaseCount][kPhaseCount];
+};
+
+struct OrchestratorOptions {
+    std::string researcherPath = "./rust_researcher";
+    bool persistentResearcher = false;
+    bool cacheResults = true;
+    ResultCacheOptions cache;
+    KnowledgeBaseOptions knowledge;
+    size_t answerPassages = 3;
+    LoggerOptions logging;
+    std::string metricsPath = "metrics.prom";
+    std::chrono::milliseconds metricsInterval{5000};
+    std::chrono::milliseconds researcherTimeout{120000};
+    Pacer pacer;
+    int inspectIteration = -1;
+    int resumeIteration = -1;
+    int64_t seed = -1;
+    std::string daemonDirectory;
+    size_t daemonWorkers = 4;
+    size_t maxResearchers = 8;
+    std::string serveSocket;
+    std::string answerBatchPath;
+    size_t serveWorkers = 0; // 0 = one per hardware thread
+    size_t fanout = 1;        // subtopics researched per RESEARCH_CYCLE
+    size_t fanoutWorkers = 0; // 0 = one per subtopic
+    PhaseRules rules;
+    bool debugScan = true;  // scan logs and sources in-process during DEBUGGING
+    DebugScanOptions debugScanOptions;
+    size_t debugScanThreads = 0; // 0 = one per hardware thread
+    std::string validationManifest = "validation.json"; // used when it exists
+    size_t validationThreads = 0; // 0 = one per hardware thread
+    uint64_t simulateRuns = 0;     // > 0: Monte Carlo mode, no research is run
+    size_t simulateThreads = 0;    // 0 = one per hardware thread
+    int simulateMaxIterations = 10000;
+    std::vector<std::string> sweeps;
+};
+
+// One research run's state machine: its config, journal, knowledge base,
+// pacer and random stream. An iteration is split around the researcher
+// call so an event loop can run that call itself: startIteration() runs the
+// current phase up to the call and reports its argv, finishResearch() takes
+// the outcome and completes the iteration. step() does both, blocking.
+//
+// A session is not thread-safe; callers hand it to one thread at a time.
+// Files live in `directory` ("" for the working directory).
+class ResearchSession {
+public:
+    ResearchSession(std::string label, std::string sessionDirectory, const OrchestratorOptions& orchestratorOptions,
+                    Logger& sessionLogger, OrchestratorMetrics& sharedMetrics, uint32_t seed)
+        : sessionName(std::move(label)),
+          directory(std::move(sessionDirectory)),
+          options(orchestratorOptions),
+          logger(sessionLogger),
+          metrics(sharedMetrics),
+          journalStore(inDirectory("config.json")),
+          knowledgeBase(knowledgeOptions(orchestratorOptions.knowledge)),
+          pacing(orchestratorOptions.pacer),
+          gen(seed) {}
+
+    bool openState() {
+        bindLogContext();
+        return journalStore.open(state);
+    }
+
+    void openKnowledge() { knowledgeBase.open(); }
+
+    // Neither is owned; both may be shared with other sessions (the cache
+    // behind `cacheMutex` when sessions run on several threads).
+    void useResultCache(ResultCache* cache, std::mutex* mutex = nullptr) {
+        resultCache = cache;
+        cacheMutex = mutex;
+    }
+    void useResearcherWorker(ResearcherWorker* worker) { researcherWorker = worker; }
+
+    // With options.fanout > 1, research cycles split the topic into that
+    // many subtopics and research them concurrently on `pool` (not owned).
+    void useFanOut(WorkStealingPool* pool) { fanOutPool = options.fanout > 1 ? pool : nullptr; }
+
+    // DEBUGGING tails logs and searches sources with `scanner` (not owned)
+    // and keeps the matches on the config; without one the commands are
+    // only narrated.
+    void useDebugScanner(DebugScanner* scanner) { debugScanner = scanner; }
+
+    // VALIDATION_TESTS runs the units of `runner` (not owned) and passes
+    // only if they do; without one the outcome is drawn from PhaseRules.
+    void useValidationRunner(ValidationRunner* runner) { validationRunner = runner; }
+
+    // Rewinds to the journaled state of `iteration`; later records are dropped.
+    bool rewindTo(int iteration) {
+        ProgramConfig earlier;
+        if (!journalStore.stateAt(iteration, earlier)) return false;
+        state = earlier;
+        journalStore.rebase(state);
+        return true;
+    }
+
+    bool finished() const {
+        return state.currentPhase == ProgramPhase::COMPLETE || state.currentPhase == ProgramPhase::QUESTION_ANSWERING ||
+               state.currentPhase == ProgramPhase::STALLED_UNRECOVERABLE;
+    }
+
+    // Runs one iteration of the current phase. Returns true when it stopped
+    // at a researcher call; run `argv` and pass the result to
+    // finishResearch(). Otherwise the iteration is complete.
+    bool startIteration(std::vector<std::string>& argv) {
+        state.researchIteration++;
+        phase = state.currentPhase;
+        phaseStarted = pacing.elapsed();
+        iterationStarted = std::chrono::steady_clock::now();
+        bindLogContext();
+        logger.info() << "\n--- Current Phase: " << phaseToString(phase) << " ---";
+        if (phase == ProgramPhase::RESEARCH_CYCLE && fanOutPool) runFanOut();
+        else if (phase == ProgramPhase::RESEARCH_CYCLE && startResearch(argv)) return true;
+        if (phase != ProgramPhase::RESEARCH_CYCLE) runPhase();
+        endIteration();
+        return false;
+    }
+
+    void finishResearch(const SubprocessResult& run) {
+        bindLogContext();
+        std::string researcherName = "Researcher '" + options.researcherPath + "'";
+        std::string failure;
+        if (!run.launched || run.timedOut) {
+            failure = run.describeFailure(researcherName);
+        } else if (!run.succeeded()) {
+            logger.warning() << "Warning: " << run.describeFailure(researcherName) << ".";
+        }
+        if (!run.errors.empty()) {
+            logger.warning() << "[ORCHESTRATOR]: Researcher diagnostics (stderr):\n" << run.errors;
+        }
+        // A researcher that exited nonzero may have printed a partial result;
+        // use it, but do not replay it from the cache.
+        applyResearch(run.output, failure, run.succeeded());
+        endIteration();
+    }
+
+    // Blocking iteration: the researcher runs on the calling thread.
+    void step() {
+        if (!startIteration(researcherArgv)) return;
+        if (researcherWorker) {
+            std::string failure;
+            {
+                ScopedSpan span(metrics.researcherCall);
+                if (!researcherWorker->request(state.researchTopic.legacy(), state.researchIteration, workerReply, options.researcherTimeout)) {
+                    failure = researcherWorker->lastError();
+                }
+            }
+            applyResearch(workerReply, failure, failure.empty());
+            endIteration();
+            return;
+        }
+        // The researcher may log around its result; the first complete object is
+        // parsed as soon as it arrives instead of after the child exits.
+        SubprocessOptions spawnOptions;
+        spawnOptions.timeout = options.researcherTimeout;
+        spawnOptions.onOutput = [&](const std::string& received) { handOff(received); };
+        {
+            ScopedSpan span(metrics.researcherCall);
+            runSubprocess(researcherArgv, spawnOptions, researchRun);
+        }
+        finishResearch(researchRun);
+    }
+
+    // Marks the session unrecoverable after a failure outside the state
+    // machine (for example an exception escaping a phase).
+    void fail(const std::string& reason) {
+        bindLogContext();
+        logger.error() << "[ORCHESTRATOR CRITICAL FAILURE]: " << reason;
+        state.lastErrorMessage = reason;
+        state.currentPhase = ProgramPhase::STALLED_UNRECOVERABLE;
+        state.researchComplete = false;
+        journalStore.record(state);
+    }
+
+    void compact() {
+        ScopedSpan span(metrics.journalCompact);
+        journalStore.compact(state);
+        knowledgeBase.sync();
+    }
+
+    const std::string& name() const { return sessionName; }
+    ProgramConfig& config() { return state; }
+    const ProgramConfig& config() const { return state; }
+    StateJournal& journal() { return journalStore; }
+    KnowledgeBase& knowledge() { return knowledgeBase; }
+    Pacer& pacer() { return pacing; }
+    Pacer::Duration phaseTotal(ProgramPhase which) const { return phaseTotals[static_cast<size_t>(which)]; }
+
+    // Tags this thread's log records with the session and its position.
+    void bindLogContext() const {
+        Logger::setSession(sessionName.empty() ? nullptr : sessionName.c_str());
+        Logger::setContext(state.researchIteration, phaseToString(state.currentPhase));
+    }
+
+private:
+    std::string inDirectory(const std::string& path) const {
+        if (directory.empty() || (!path.empty() && path[0] == '/')) return path;
+        return directory + "/" + path;
+    }
+
+    KnowledgeBaseOptions knowledgeOptions(KnowledgeBaseOptions base) const {
+        base.directory = inDirectory(base.directory);
+        return base;
+    }
+
+    void handOff(const std::string& received) {
+        if (!researchScanner.complete() && researchScanner.feed(received)) {
+            researchPayload.assign(researchScanner.object(received));
+            ScopedSpan span(metrics.researcherParse);
+            parsed = researchDoc.parse(researchPayload);
+        }
+    }
+
+    // RESEARCH_CYCLE up to the researcher call. Returns false when a cached
+    // result completed the phase without one.
+    bool startResearch(std::vector<std::string>& argv) {
+        logger.info() << "[ORCHESTRATOR]: Initiating Deep Research Cycle #" << state.researchIteration << " on current topic: '" << state.researchTopic.display() << "'.";
+        simulateTerminalTyping(logger, pacing, options.researcherPath + " \"" + state.researchTopic.legacy() + "\" " + std::to_string(state.researchIteration));
+
+        parsed = false;
+        researchScanner.reset();
+        bool cached = false;
+        if (resultCache) {
+            ScopedSpan span(metrics.cacheLookup);
+            std::unique_lock<std::mutex> lock;
+            if (cacheMutex) lock = std::unique_lock<std::mutex>(*cacheMutex);
+            cached = resultCache->lookup(state.researchTopic.legacy(), state.researchIteration, cachedOutput);
+        }
+        if (cached) {
+            logger.info() << "[ORCHESTRATOR]: Identical research request already answered by this researcher build; reusing the cached result.";
+            applyResearch(cachedOutput, "", false);
+            return false;
+        }
+        argv.assign({options.researcherPath, state.researchTopic.legacy(), std::to_string(state.researchIteration)});
+        return true;
+    }
+
+    // `cacheable`: the output came from a successful researcher call, not
+    // from the cache, and may be stored for identical requests.
+    void applyResearch(const std::string& research_output, const std::string& researchFailure, bool cacheable) {
+        logger.info() << "[ORCHESTRATOR]: Captured output from Rust Researcher:\n" << research_output;
+
+        if (!researchFailure.empty()) {
+            metrics.researcherFailures.increment();
+            state.lastErrorMessage = researchFailure;
+            logger.info() << "[ORCHESTRATOR]: Research module failure: " << researchFailure << ". Transitioning to DEBUGGING phase for immediate self-correction.";
+            state.currentPhase = ProgramPhase::DEBUGGING;
+            return;
+        }
+
+        handOff(research_output);
+        JsonRef rust_results;
+        if (parsed) {
+            rust_results = researchDoc.root();
+            if (resultCache && cacheable) {
+                std::unique_lock<std::mutex> lock;
+                if (cacheMutex) lock = std::unique_lock<std::mutex>(*cacheMutex);
+                resultCache->store(state.researchTopic.legacy(), state.researchIteration, researchPayload);
+            }
+        } else {
+            logger.warning() << "Warning: Could not parse researcher output as JSON: "
+                             << (researchScanner.complete() ? researchDoc.error() : "no JSON object found");
+        }
+
+        if (JsonRef summary = rust_results["research_summary"]) {
+            state.lastResearchSummary = std::string(summary.asString());
+            {
+                ScopedSpan span(metrics.knowledgeAdd);
+                knowledgeBase.add(state.researchIteration, state.researchTopic.legacy(), state.lastResearchSummary);
+            }
+            logger.info() << "[ORCHESTRATOR]: Updated internal research summary based on the latest findings from the Rust module (knowledge base now holds " << knowledgeBase.size() << " passages).";
+        }
+        if (JsonRef score = rust_results["research_completeness_score"]) {
+             state.researchCompletenessScore = score.asNumber(state.researchCompletenessScore);
+             logger.info() << "[ORCHESTRATOR]: Progress update: Research completeness score is now " << state.researchCompletenessScore << "%.";
+        }
+
+        if (rust_results["error_found"].asBool()) {
+            state.lastErrorMessage = std::string(rust_results["error_message"].asString("Unknown error from researcher."));
+            logger.info() << "[ORCHESTRATOR]: Critical anomaly detected during research. Transitioning to DEBUGGING phase for immediate self-correction.";
+            state.currentPhase = ProgramPhase::DEBUGGING;
+        } else {
+            advanceResearch();
+        }
+    }
+
+    // The transitions after a research cycle that found no error.
+    void advanceResearch() {
+        state.lastErrorMessage = "None";
+        state.debugAttempts = 0;
+        if (state.researchIteration % 2 == 0 && state.researchCompletenessScore < 90) {
+            state.researchTopic.push(TopicOp::DEEPEN);
+            logger.info() << "[ORCHESTRATOR]: Current research trajectory stable. Initiating deeper exploration into '" << state.researchTopic.display() << "' to extract more granular insights.";
+        }
+
+        if (options.rules.researchConcluded(state.researchCompletenessScore) && !state.lastErrorMessage.empty() && state.lastErrorMessage == "None") {
+            state.researchComplete = true;
+            logger.info() << "[ORCHESTRATOR]: Core research objectives are fulfilled. Entering FINAL_ANALYSIS phase to synthesize conclusive findings.";
+            state.currentPhase = ProgramPhase::FINAL_ANALYSIS;
+        } else if (options.rules.entersLlmIntegration(state.researchIteration, state.llama3SimulatedDownloaded, [this] { return dis(gen); })) {
+            state.currentPhase = ProgramPhase::LLM_INTEGRATION;
+            logger.info() << "[ORCHESTRATOR]: Sufficient foundational context acquired. Preparing for Llama3 8B integration to elevate research capabilities.";
+        }
+    }
+
+    struct ShardOutcome {
+        std::string query;
+        SubprocessResult run;
+        std::string output;
+        bool cached = false;
+        bool parsed = false;
+        std::string failure;
+        std::string summary;
+        bool hasSummary = false;
+        double score = 0.0;
+        bool hasScore = false;
+        bool errorFound = false;
+        std::string errorMessage;
+    };
+
+    static std::string subtopicLabel(size_t shard, size_t shards) { return std::to_string(shard + 1) + "/" + std::to_string(shards); }
+
+    // RESEARCH_CYCLE as options.fanout concurrent researcher calls, one per
+    // subtopic "<topic>/<k>-of-<n>".
+    void runFanOut() {
+        size_t shards = options.fanout;
+        const std::string& topic = state.researchTopic.legacy();
+        logger.info() << "[ORCHESTRATOR]: Initiating Deep Research Cycle #" << state.researchIteration << " on current topic: '" << state.researchTopic.display()
+                      << "', fanned out into " << shards << " subtopics.";
+        simulateTerminalTyping(logger, pacing, options.researcherPath + " \"" + topic + "/{1.." + std::to_string(shards) + "}-of-" + std::to_string(shards) + "\" " +
+                                                   std::to_string(state.researchIteration) + " (x" + std::to_string(shards) + " in parallel)");
+        shardOutcomes.resize(shards);
+        for (size_t i = 0; i < shards; ++i) shardOutcomes[i].query = topic + "/" + std::to_string(i + 1) + "-of-" + std::to_string(shards);
+        fanOutPool->parallelFor(shards, [&](size_t i) { researchShard(shardOutcomes[i]); });
+        mergeShards();
+    }
+
+    // Runs on a pool thread: no logging and no session state beyond the
+    // shard, the (locked) cache and the metrics atomics.
+    void researchShard(ShardOutcome& shard) {
+        shard.cached = shard.parsed = shard.hasSummary = shard.hasScore = shard.errorFound = false;
+        shard.failure.clear();
+        shard.run.errors.clear();
+        std::mutex& cacheLock = cacheMutex ? *cacheMutex : shardCacheMutex;
+        if (resultCache) {
+            ScopedSpan span(metrics.cacheLookup);
+            std::lock_guard<std::mutex> lock(cacheLock);
+            shard.cached = resultCache->lookup(shard.query, state.researchIteration, shard.output);
+        }
+        if (!shard.cached) {
+            SubprocessOptions spawnOptions;
+            spawnOptions.timeout = options.researcherTimeout;
+            {
+                ScopedSpan span(metrics.researcherCall);
+                runSubprocess({options.researcherPath, shard.query, std::to_string(state.researchIteration)}, spawnOptions, shard.run);
+            }
+            shard.output.swap(shard.run.output);
+            if (!shard.run.launched || shard.run.timedOut) {
+                shard.failure = shard.run.describeFailure("Researcher '" + options.researcherPath + "'");
+                return;
+            }
+        }
+
+        JsonStreamScanner scanner;
+        JsonDocument doc;
+        std::string payload;
+        if (scanner.feed(shard.output)) {
+            payload.assign(scanner.object(shard.output));
+            ScopedSpan span(metrics.researcherParse);
+            shard.parsed = doc.parse(payload);
+        }
+        if (!shard.parsed) return;
+        if (resultCache && !shard.cached && shard.run.succeeded()) {
+            std::lock_guard<std::mutex> lock(cacheLock);
+            resultCache->store(shard.query, state.researchIteration, payload);
+        }
+        JsonRef root = doc.root();
+        if (JsonRef summary = root["research_summary"]) {
+            shard.summary.assign(summary.asString());
+            shard.hasSummary = true;
+        }
+        if (JsonRef score = root["research_completeness_score"]) {
+            shard.score = score.asNumber(0.0);
+            shard.hasScore = true;
+        }
+        shard.errorFound = root["error_found"].asBool();
+        if (shard.errorFound) shard.errorMessage.assign(root["error_message"].asString("Unknown error from researcher."));
+    }
+
+    // Combines the shards in subtopic order, so the result does not depend
+    // on which finished first:
+    //  - each summary becomes its own knowledge passage, and the merged
+    //    summary is "[1/n] ... [2/n] ...";
+    //  - the completeness score is the mean over all n shards, where a shard
+    //    that failed or reported no score counts as the previous score;
+    //  - a shard that failed or reported error_found sends the cycle to
+    //    DEBUGGING with the first such shard's message.
+    void mergeShards() {
+        size_t shards = shardOutcomes.size();
+        double previousScore = state.researchCompletenessScore;
+        double scoreTotal = 0.0;
+        std::string merged;
+        std::string firstError;
+        for (size_t i = 0; i < shards; ++i) {
+            const ShardOutcome& shard = shardOutcomes[i];
+            std::string label = subtopicLabel(i, shards);
+            logger.info() << "[ORCHESTRATOR]: Captured output from Rust Researcher for subtopic " << label << (shard.cached ? " (cached)" : "") << ":\n" << shard.output;
+            if (!shard.cached && !shard.failure.empty()) {
+                metrics.researcherFailures.increment();
+                if (firstError.empty()) firstError = "Subtopic " + label + ": " + shard.failure;
+                scoreTotal += previousScore;
+                continue;
+            }
+            if (!shard.cached && !shard.run.succeeded()) {
+                logger.warning() << "Warning: " << shard.run.describeFailure("Researcher '" + options.researcherPath + "'") << " (subtopic " << label << ").";
+            }
+            if (!shard.run.errors.empty()) logger.warning() << "[ORCHESTRATOR]: Researcher diagnostics for subtopic " << label << " (stderr):\n" << shard.run.errors;
+            if (!shard.parsed) logger.warning() << "Warning: Could not parse researcher output for subtopic " << label << " as JSON.";
+            if (shard.hasSummary) {
+                {
+                    ScopedSpan span(metrics.knowledgeAdd);
+                    knowledgeBase.add(state.researchIteration, shard.query, shard.summary);
+                }
+                if (!merged.empty()) merged += ' ';
+                merged += "[" + label + "] " + shard.summary;
+            }
+            scoreTotal += shard.hasScore ? shard.score : previousScore;
+            if (shard.errorFound && firstError.empty()) firstError = "Subtopic " + label + ": " + shard.errorMessage;
+        }
+
+        if (!merged.empty()) {
+            state.lastResearchSummary = std::move(merged);
+            logger.info() << "[ORCHESTRATOR]: Merged the findings of " << shards << " subtopics into the research summary (knowledge base now holds " << knowledgeBase.size() << " passages).";
+        }
+        state.researchCompletenessScore = scoreTotal / static_cast<double>(shards);
+        logger.info() << "[ORCHESTRATOR]: Progress update: Combined research completeness score is now " << state.researchCompletenessScore << "%.";
+
+        if (!firstError.empty()) {
+            state.lastErrorMessage = firstError;
+            logger.info() << "[ORCHESTRATOR]: Critical anomaly detected during research (" << firstError << "). Transitioning to DEBUGGING phase for immediate self-correction.";
+            state.currentPhase = ProgramPhase::DEBUGGING;
+        } else {
+            advanceResearch();
+        }
+    }
+
+    // Every phase except RESEARCH_CYCLE, which has no external I/O.
+    void runPhase() {
+        bool passed = false; // VALIDATION_TESTS outcome
+        switch (state.currentPhase) {
+            case ProgramPhase::INITIAL_SETUP:
+                logger.info() << "[ORCHESTRATOR]: Commencing initial project setup and environment configuration.";
+                simulateTerminalTyping(logger, pacing, "git clone https://github.com/autonomous-deep-research/project.git");
+                logger.info() << "[ORCHESTRATOR]: Repository cloned successfully. Now inspecting the project for foundational components.";
+                pacing.pause(std::chrono::seconds(2));
+                simulateTerminalTyping(logger, pacing, "ls -F");
+                logger.info() << "[ORCHESTRATOR]: Identified source directories and configuration files. Proceeding with dependency analysis.";
+                pacing.pause(std::chrono::seconds(2));
+                simulateTerminalTyping(logger, pacing, "pip install -r requirements.txt");
+                logger.info() << "[ORCHESTRATOR]: All initial dependencies installed and verified. Environment is ready for core operations.";
+                state.currentPhase = ProgramPhase::RESEARCH_CYCLE;
+                break;
+
+            case ProgramPhase::LLM_INTEGRATION:
+                if (!state.llama3SimulatedDownloaded) {
+                    logger.info() << "\n[ORCHESTRATOR]: Initiating the intricate process of Llama3 8B model acquisition and environmental calibration.";
+                    simulateTerminalTyping(logger, pacing, "wget https://simulated.llm-repo.org/llama3-8b.tar.gz -O ./models/llama3-8b.tar.gz");
+                    logger.info() << "[ORCHESTRATOR]: Llama3 8B model download sequence initiated. Monitoring data stream integrity and progress...";
+                    pacing.pause(std::chrono::seconds(3));
+                    simulateTerminalTyping(logger, pacing, "tar -xzf ./models/llama3-8b.tar.gz -C ./models/");
+                    logger.info() << "[ORCHESTRATOR]: Decompressing and extracting Llama3 8B model archives to designated directory. This is a resource-intensive operation.";
+                    pacing.pause(std::chrono::seconds(2));
+                    simulateTerminalTyping(logger, pacing, "python3 -m venv llm_env && source llm_env/bin/activate");
+                    logger.info() << "[ORCHESTRATOR]: Creating a dedicated, isolated Python virtual environment to host the Llama3 operations, ensuring no conflicts.";
+                    pacing.pause(std::chrono::seconds(1));
+                    simulateTerminalTyping(logger, pacing, "pip install transformers torch accelerate bitsandbytes");
+                    logger.info() << "[ORCHESTRATOR]: Installing essential Python libraries for Llama3 inference and fine-tuning. Optimizing for hardware acceleration.";
+                    pacing.pause(std::chrono::seconds(2));
+                    logger.info() << "[ORCHESTRATOR]: Llama3 8B model successfully integrated, validated, and prepared for advanced research queries and contextual understanding.";
+                    state.llama3SimulatedDownloaded = true;
+                }
+                logger.info() << "[ORCHESTRATOR]: Llama3 8B is now online. Resuming RESEARCH_CYCLE with profoundly enhanced analytical and generative capabilities.";
+                state.currentPhase = ProgramPhase::RESEARCH_CYCLE;
+                break;
+
+            case ProgramPhase::DEBUGGING:
+                state.debugAttempts++;
+                metrics.debugAttempts.increment();
+                logger.info() << "[ORCHESTRATOR]: System anomaly identified: " << state.lastErrorMessage << ". Initiating precise diagnostic protocols (Attempt " << state.debugAttempts << "). Analyzing failure signature.";
+                if (debugScanner) {
+                    diagnose();
+                } else {
+                    simulateTerminalTyping(logger, pacing, "find . -name '*.log' -exec tail -n 10 {} \\;");
+                    logger.info() << "[ORCHESTRATOR]: Retrieving and analyzing most recent log entries across all modules for comprehensive error tracing.";
+                    pacing.pause(std::chrono::seconds(2));
+                    simulateTerminalTyping(logger, pacing, "grep -r '" + state.lastErrorMessage + "' ./src/");
+                    logger.info() << "[ORCHESTRATOR]: Executing targeted code search to pinpoint exact problematic functions or data structures related to the error.";
+                    pacing.pause(std::chrono::seconds(2));
+                }
+
+                simulateCodeModification(logger, pacing, "./rust_researcher/src/main.rs", "error resolution for '" + state.lastErrorMessage + "' based on diagnostic insights");
+                state.researchTopic.push(TopicOp::FIX);
+
+                logger.info() << "[ORCHESTRATOR]: Transitioning to VALIDATION_TESTS phase to rigorously confirm the effectiveness of the self-applied code correction.";
+                state.currentPhase = ProgramPhase::VALIDATION_TESTS;
+                break;
+
+            case ProgramPhase::VALIDATION_TESTS:
+                logger.info() << "[ORCHESTRATOR]: Initiating a suite of comprehensive unit and integration tests to validate the integrity and effectiveness of the self-modification.";
+                if (validationRunner) {
+                    passed = validate();
+                } else {
+                    simulateTerminalTyping(logger, pacing, "cargo test --workspace -- --test-threads=1 --nocapture");
+                    logger.info() << "[ORCHESTRATOR]: Running all test cases, monitoring for any regressions or residual issues from the self-applied patch.";
+                    pacing.pause(std::chrono::seconds(3));
+                    passed = options.rules.validationPasses(state.debugAttempts, [this] { return dis(gen); });
+                }
+                if (passed) {
+                    logger.info() << "[ORCHESTRATOR]: All self-tests passed successfully! The self-modification has been verified to resolve the issue and maintain system stability.";
+                    simulateTerminalTyping(logger, pacing, "cargo build --release");
+                    logger.info() << "[ORCHESTRATOR]: Recompiling the entire research module with the validated and integrated fixes. Resuming RESEARCH_CYCLE.";
+                    state.lastErrorMessage = "None";
+                    state.currentPhase = ProgramPhase::RESEARCH_CYCLE;
+                    state.debugAttempts = 0;
+                    state.debugMatches.clear();
+                } else {
+                    metrics.validationFailures.increment();
+                    logger.info() << "[ORCHESTRATOR]: Validation tests failed. The self-modification requires further refinement or a different approach. Re-entering DEBUGGING phase.";
+                    state.currentPhase = ProgramPhase::DEBUGGING;
+                }
+
+                if (options.rules.debugExhausted(state.debugAttempts)) {
+                    logger.error() << "[ORCHESTRATOR CRITICAL FAILURE]: Multiple debug attempts and validation failures indicate a deeply embedded, unrecoverable systemic error. Autonomous operation cannot continue.";
+                    state.lastErrorMessage = "Unrecoverable systemic error after " + std::to_string(state.debugAttempts) + " attempts. Manual intervention required.";
+                    state.currentPhase = ProgramPhase::STALLED_UNRECOVERABLE;
+                    state.researchComplete = false;
+                    logger.flush(true);
+                }
+                break;
+
+            case ProgramPhase::FINAL_ANALYSIS:
+                logger.info() << "[ORCHESTRATOR]: Entering the FINAL_ANALYSIS phase: Synthesizing all accumulated data into a cohesive, actionable knowledge base.";
+                simulateTerminalTyping(logger, pacing, "python3 ./scripts/consolidate_data.py --input_dir ./research_data/ --output_dir ./final_reports/ --optimize --cross-validate");
+                logger.info() << "[ORCHESTRATOR]: All iterative findings, self-corrections, and LLM-enhanced insights are being rigorously aggregated.";
+                pacing.pause(std::chrono::seconds(3));
+                simulateTerminalTyping(logger, pacing, "python3 ./scripts/generate_report.py --knowledge_base ./final_reports/ --format markdown --detailed --peer-review --executive-summary");
+                logger.info() << "[ORCHESTRATOR]: Comprehensive final report generated, encompassing all validated conclusions and supporting evidence. The deep research is now functionally complete and available for inquiry.";
+                state.currentPhase = ProgramPhase::QUESTION_ANSWERING;
+                state.researchComplete = true;
+                break;
+
+            default:
+                logger.error() << "[ORCHESTRATOR FATAL ERROR]: Encountered an unhandled or unexpected program phase. Terminating autonomous operations immediately.";
+                state.currentPhase = ProgramPhase::COMPLETE;
+                break;
+        }
+    }
+
+    // VALIDATION_TESTS against the manifest. Every unit's outcome is kept on
+    // the config; returns whether all of them passed.
+    bool validate() {
+        validationRunner->run(validationReport);
+        const std::vector<ValidationUnit>& units = validationRunner->manifest();
+        state.validationResults.clear();
+        for (size_t i = 0; i < units.size(); ++i) {
+            const ValidationShard& shard = validationReport.shards[i];
+            state.validationResults.push_back({units[i].name, shardStatusToString(shard.status), static_cast<int64_t>(shard.elapsed.count())});
+            if (shard.status == ShardStatus::PASSED || shard.status == ShardStatus::FAILED || shard.status == ShardStatus::TIMED_OUT) {
+                metrics.validationShard.record(shard.elapsed);
+            }
+            logger.info() << "[ORCHESTRATOR]: Test unit '" << units[i].name << "': " << shardStatusToString(shard.status)
+                          << (shard.status == ShardStatus::CACHED || shard.status == ShardStatus::SKIPPED ? "" : " in " + std::to_string(shard.elapsed.count() / 1000.0) + "s");
+        }
+        logger.info() << "[ORCHESTRATOR]: " << units.size() << " test units: " << validationReport.cached << " unchanged since they last passed, "
+                      << validationReport.ran << " run.";
+        if (!validationReport.passed) logger.info() << "[ORCHESTRATOR]: " << validationReport.shards[validationReport.firstFailure].detail;
+        return validationReport.passed;
+    }
+
+    // DEBUGGING's log tails and signature search, run in-process.
+    void diagnose() {
+        const DebugScanOptions& scan = debugScanner->settings();
+        {
+            ScopedSpan span(metrics.debugScan);
+            debugScanner->scan(state.lastErrorMessage, scanResult);
+        }
+        logger.info() << "[ORCHESTRATOR]: Scanned '" << scan.root << "' for log files and '" << scan.sourceDirectory << "' for the error signature: "
+                      << scanResult.filesSeen << " files, " << scanResult.filesScanned << " read since the previous scan.";
+        for (const LogTail& tail : scanResult.tails) {
+            LogLine lines = logger.info();
+            lines << "[ORCHESTRATOR]: Last " << tail.lines.size() << " lines of '" << tail.file << "':";
+            for (const std::string& line : tail.lines) lines << "\n  " << line;
+        }
+        for (const DebugMatch& match : scanResult.matches) {
+            logger.info() << "[ORCHESTRATOR]: Error signature at " << match.file << ":" << match.line << ": " << match.context;
+        }
+        logger.info() << "[ORCHESTRATOR]: " << scanResult.matches.size() << (scanResult.truncated ? "+" : "") << " source lines match the error signature"
+                      << (scanResult.matches.empty() ? "." : "; recorded for this debug cycle.");
+        state.debugMatches = scanResult.matches;
+    }
+
+    void endIteration() {
+        {
+            ScopedSpan span(metrics.journalRecord);
+            journalStore.record(state);
+        }
+        logger.info() << "[ORCHESTRATOR]: Current operational state and research progress recorded to '" << journalStore.journalFile() << "' for persistent memory.";
+        pacing.pause(std::chrono::seconds(1));
+
+        // Durations come from the pacer's virtual clock, so they read the same in every pacing mode.
+        Pacer::Duration phaseTime = pacing.elapsed() - phaseStarted;
+        phaseTotals[static_cast<size_t>(phase)] += phaseTime;
+        logger.info() << "[ORCHESTRATOR]: " << phaseToString(phase) << " phase took " << phaseTime.count() / 1000.0 << "s.";
+
+        metrics.phaseDuration[static_cast<size_t>(phase)]->record(std::chrono::steady_clock::now() - iterationStarted);
+        metrics.iterations.increment();
+        if (state.currentPhase != phase) metrics.transitions[static_cast<size_t>(phase)][static_cast<size_t>(state.currentPhase)]->increment();
+        metrics.completeness.set(state.researchCompletenessScore);
+        metrics.iteration.set(state.researchIteration);
+    }
+
+    std::string sessionName;
+    std::string directory;
+    const OrchestratorOptions& options;
+    Logger& logger;
+    OrchestratorMetrics& metrics;
+    ProgramConfig state;
+    StateJournal journalStore;
+    KnowledgeBase knowledgeBase;
+    Pacer pacing;
+    std::mt19937 gen;
+    std::uniform_real_distribution<> dis{0.0, 1.0};
+    ResultCache* resultCache = nullptr;
+    std::mutex* cacheMutex = nullptr;
+    ResearcherWorker* researcherWorker = nullptr;
+    WorkStealingPool* fanOutPool = nullptr;
+    std::mutex shardCacheMutex;
+    std::vector<ShardOutcome> shardOutcomes;
+    DebugScanner* debugScanner = nullptr;
+    DebugScanResult scanResult;
+    ValidationRunner* validationRunner = nullptr;
+    ValidationReport validationReport;
+
+    ProgramPhase phase = ProgramPhase::INITIAL_SETUP;
+    Pacer::Duration phaseStarted{0};
+    std::chrono::steady_clock::time_point iterationStarted;
+    Pacer::Duration phaseTotals[kPhaseCount] = {};
+
+    // Reused across iterations so steady-state research cycles do not reallocate.
+    std::vector<std::string> researcherArgv;
+    SubprocessResult researchRun;
+    std::string workerReply;
+    std::string cachedOutput;
+    std::string researchPayload;
+    JsonStreamScanner researchScanner;
+    JsonDocument researchDoc;
+    bool parsed = false;
+};
@@ -0,0 +1,211 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include "json.h"
+
+enum class TopicOp : uint8_t { DEEPEN, FIX, REFINE };
+
+constexpr size_t kTopicOpCount = static_cast<size_t>(TopicOp::REFINE) + 1;
+
+inline const char* topicOpToString(TopicOp op) {
+    switch (op) {
+        case TopicOp::DEEPEN: return "deepen";
+        case TopicOp::FIX: return "fix";
+        case TopicOp::REFINE: return "refine";
+    }
+    return "unknown";
+}
+
+inline bool topicOpFromString(std::string_view name, TopicOp& op) {
+    for (size_t i = 0; i < kTopicOpCount; ++i) {
+        if (name == topicOpToString(static_cast<TopicOp>(i))) {
+            op = static_cast<TopicOp>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Base topics are interned process-wide, so a lineage holds one pointer and
+// comparing bases is a pointer comparison. Interned strings live until exit.
+inline const std::string* internTopic(std::string_view name) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string> pool;
+    std::lock_guard<std::mutex> lock(mutex);
+    return &*pool.emplace(name).first;
+}
+
+// A research topic as a base plus the stack of deepen/fix/refine steps
+// applied to it, replacing the "deepen_fix_deepen_<base>" strings that grew
+// by one prefix per step. Consecutive equal steps are run-length encoded.
+// A run folds into per-op totals only once all of its steps are older than
+// the newest kMaxLegacyPrefixes, so at most kMaxLegacyPrefixes + 1 runs are
+// kept and the serialized form stays bounded however long research runs.
+//
+// legacy() renders the old prefixed string for the researcher from the
+// newest kMaxLegacyPrefixes steps; display() is a short human form.
+// Both are cached until the next push.
+class ResearchTopic {
+public:
+    static constexpr size_t kMaxLegacyPrefixes = 64;
+
+    ResearchTopic() : ResearchTopic("general_knowledge") {}
+    explicit ResearchTopic(std::string_view baseTopic) : baseName(internTopic(baseTopic)) {}
+
+    // Parses a legacy prefixed topic string, such as an old config.json value.
+    static ResearchTopic fromLegacy(std::string_view text) {
+        std::vector<TopicOp> outermostFirst;
+        for (bool stripped = true; stripped;) {
+            stripped = false;
+            for (size_t i = 0; i < kTopicOpCount && !stripped; ++i) {
+                std::string_view prefix = topicOpToString(static_cast<TopicOp>(i));
+                if (text.size() > prefix.size() + 1 && text.compare(0, prefix.size(), prefix) == 0 && text[prefix.size()] == '_') {
+                    outermostFirst.push_back(static_cast<TopicOp>(i));
+                    text.remove_prefix(prefix.size() + 1);
+                    stripped = true;
+                }
+            }
+        }
+        ResearchTopic topic(text);
+        for (auto op = outermostFirst.rbegin(); op != outermostFirst.rend(); ++op) topic.push(*op);
+        return topic;
+    }
+
+    void push(TopicOp op) { push(op, 1); }
+
+    const std::string& base() const { return *baseName; }
+
+    uint64_t count(TopicOp op) const {
+        uint64_t total = elided[static_cast<size_t>(op)];
+        for (const Run& run : runs) {
+            if (run.op == op) total += run.count;
+        }
+        return total;
+    }
+
+    uint64_t depth() const {
+        uint64_t total = 0;
+        for (size_t i = 0; i < kTopicOpCount; ++i) total += count(static_cast<TopicOp>(i));
+        return total;
+    }
+
+    const std::string& legacy() const {
+        if (!legacyValid) {
+            legacyCache.clear();
+            size_t budget = kMaxLegacyPrefixes;
+            for (auto run = runs.rbegin(); run != runs.rend() && budget > 0; ++run) {
+                for (uint32_t i = 0; i < run->count && budget > 0; ++i, --budget) {
+                    legacyCache += topicOpToString(run->op);
+                    legacyCache += '_';
+                }
+            }
+            legacyCache += *baseName;
+            legacyValid = true;
+        }
+        return legacyCache;
+    }
+
+    const std::string& display() const {
+        if (!displayValid) {
+            displayCache = *baseName;
+            const char* separator = " (";
+            for (size_t i = 0; i < kTopicOpCount; ++i) {
+                uint64_t total = count(static_cast<TopicOp>(i));
+                if (total == 0) continue;
+                displayCache += separator;
+                displayCache += topicOpToString(static_cast<TopicOp>(i));
+                displayCache += " x" + std::to_string(total);
+                separator = ", ";
+            }
+            if (runs.size() + elided[0] + elided[1] + elided[2] > 0) displayCache += ')';
+            displayValid = true;
+        }
+        return displayCache;
+    }
+
+    // {"base": "...", "ops": [["deepen", 2], ["fix", 1]], "elided": {...}}
+    // with runs oldest first; "elided" is omitted while nothing was folded.
+    void write(JsonWriter& writer) const {
+        writer.beginObject();
+        writer.member("base", *baseName);
+        writer.key("ops");
+        writer.beginArray();
+        for (const Run& run : runs) {
+            writer.beginArray();
+            writer.value(topicOpToString(run.op));
+            writer.value(run.count);
+            writer.endArray();
+        }
+        writer.endArray();
+        if (elided[0] + elided[1] + elided[2] > 0) {
+            writer.key("elided");
+            writer.beginObject();
+            for (size_t i = 0; i < kTopicOpCount; ++i) writer.member(topicOpToString(static_cast<TopicOp>(i)), elided[i]);
+            writer.endObject();
+        }
+        writer.endObject();
+    }
+
+    bool read(JsonRef data) {
+        if (!data.isObject() || !data["base"].isString()) return false;
+        ResearchTopic parsed(data["base"].asString());
+        bool valid = true;
+        data["ops"].forEachElement([&](JsonRef run) {
+            TopicOp op;
+            long long times = run.at(1).asInt(0);
+            if (!topicOpFromString(run.at(0).asString(), op) || times <= 0 || times > UINT32_MAX) {
+                valid = false;
+                return;
+            }
+            parsed.push(op, static_cast<uint32_t>(times));
+        });
+        for (size_t i = 0; i < kTopicOpCount; ++i) {
+            parsed.elided[i] += static_cast<uint64_t>(std::max(0LL, data["elided"][topicOpToString(static_cast<TopicOp>(i))].asInt(0)));
+        }
+        if (!valid) return false;
+        *this = std::move(parsed);
+        return true;
+    }
+
+    bool operator==(const ResearchTopic& other) const {
+        return baseName == other.baseName && runs == other.runs && elided[0] == other.elided[0] &&
+               elided[1] == other.elided[1] && elided[2] == other.elided[2];
+    }
+    bool operator!=(const ResearchTopic& other) const { return !(*this == other); }
+
+private:
+    struct Run {
+        TopicOp op;
+        uint32_t count;
+        bool operator==(const Run& other) const { return op == other.op && count == other.count; }
+    };
+
+    void push(TopicOp op, uint32_t times) {
+        if (!runs.empty() && runs.back().op == op) runs.back().count += times;
+        else runs.push_back(Run{op, times});
+        keptSteps += times;
+        while (keptSteps - runs.front().count >= kMaxLegacyPrefixes) {
+            elided[static_cast<size_t>(runs.front().op)] += runs.front().count;
+            keptSteps -= runs.front().count;
+            runs.erase(runs.begin());
+        }
+        legacyValid = false;
+        displayValid = false;
+    }
+
+    const std::string* baseName;
+    std::vector<Run> runs; // oldest first
+    uint64_t keptSteps = 0; // total count over runs
+    uint64_t elided[kTopicOpCount] = {};
+    mutable std::string legacyCache;
+    mutable std::string displayCache;
+    mutable bool legacyValid = false;
+    mutable bool displayValid = false;
+};
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "subprocess.h"
+
+// Framing used between the orchestrator and a long-lived researcher started
+// with --serve: every message is a 4-byte big-endian payload length followed
+// by the payload. Requests are {"topic": ..., "iteration": N}; replies are
+// the same JSON object the researcher prints in one-shot mode.
+constexpr uint32_t kMaxFrameBytes = 64u * 1024u * 1024u;
+
+inline bool writeAll(int fd, const char* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Blocking read of exactly `size` bytes; gives up once `deadline` passes.
+inline bool readAll(int fd, char* data, size_t size, SteadyClock::time_point deadline = SteadyClock::time_point::max()) {
+    while (size > 0) {
+        if (deadline != SteadyClock::time_point::max()) {
+            pollfd entry{fd, POLLIN, 0};
+            int waitMs = pollTimeoutMs(deadline);
+            int ready = waitMs == 0 ? 0 : poll(&entry, 1, waitMs);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) return false;
+        }
+        ssize_t got = ::read(fd, data, size);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (got == 0) return false;
+        data += got;
+        size -= static_cast<size_t>(got);
+    }
+    return true;
+}
+
+inline bool writeFrame(int fd, std::string_view payload) {
+    if (payload.size() > kMaxFrameBytes) return false;
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    char header[4] = {static_cast<char>(size >> 24), static_cast<char>(size >> 16),
+                      static_cast<char>(size >> 8), static_cast<char>(size)};
+    return writeAll(fd, header, sizeof(header)) && writeAll(fd, payload.data(), payload.size());
+}
+
+// Reads one frame into `payload`, reusing its capacity. Returns false on EOF,
+// I/O error, an oversized length prefix or when `deadline` passes.
+inline bool readFrame(int fd, std::string& payload, SteadyClock::time_point deadline = SteadyClock::time_point::max()) {
+    unsigned char header[4];
+    if (!readAll(fd, reinterpret_cast<char*>(header), sizeof(header), deadline)) return false;
+    uint32_t size = (uint32_t(header[0]) << 24) | (uint32_t(header[1]) << 16) |
+                    (uint32_t(header[2]) << 8) | uint32_t(header[3]);
+    if (size > kMaxFrameBytes) return false;
+    payload.resize(size);
+    return size == 0 || readAll(fd, &payload[0], size, deadline);
+}
+
+// Keeps one researcher process alive across iterations and talks to it over
+// stdin/stdout pipes. If the child dies mid-request it is respawned and the
+// request is retried, up to `maxRestartsPerRequest` times.
+class ResearcherWorker {
+public:
+    explicit ResearcherWorker(std::string executablePath, int maxRestarts = 2)
+        : executable(std::move(executablePath)), maxRestartsPerRequest(maxRestarts) {}
+
+    ~ResearcherWorker() { stop(); }
+
+    ResearcherWorker(const ResearcherWorker&) = delete;
+    ResearcherWorker& operator=(const ResearcherWorker&) = delete;
+
+    bool start() {
+        if (pid > 0) return true;
+        std::signal(SIGPIPE, SIG_IGN);
+
+        int requestPipe[2];
+        int replyPipe[2];
+        if (pipe2(requestPipe, O_CLOEXEC) != 0) {
+            std::cerr << "Error: pipe() failed for researcher worker." << std::endl;
+            return false;
+        }
+        if (pipe2(replyPipe, O_CLOEXEC) != 0) {
+            std::cerr << "Error: pipe() failed for researcher worker." << std::endl;
+            ::close(requestPipe[0]);
+            ::close(requestPipe[1]);
+            return false;
+        }
+
+        pid_t child = spawnProcess({executable, "--serve"}, requestPipe[0], replyPipe[1], -1, false);
+        ::close(requestPipe[0]);
+        ::close(replyPipe[1]);
+        if (child < 0) {
+            std::cerr << "Error: Could not launch researcher worker '" << executable << "'." << std::endl;
+            ::close(requestPipe[1]);
+            ::close(replyPipe[0]);
+            return false;
+        }
+        pid = child;
+        toChild = requestPipe[1];
+        fromChild = replyPipe[0];
+        ++launchCount;
+        return true;
+    }
+
+    // Sends one (topic, iteration) request and stores the reply payload in
+    // `reply`. A crashed worker is restarted and the request retried; a worker
+    // that misses `timeout` is killed instead, since retrying would only hang
+    // again. On failure lastError() says why.
+    bool request(std::string_view topic, int iteration, std::string& reply,
+                 std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) {
+        requestBuffer.clear();
+        JsonWriter writer(requestBuffer, false);
+        writer.beginObject();
+        writer.member("topic", topic);
+        writer.member("iteration", iteration);
+        writer.endObject();
+        failure.clear();
+
+        auto deadline = deadlineAfter(timeout);
+        for (int attempt = 0; attempt <= maxRestartsPerRequest; ++attempt) {
+            if (pid <= 0 && !start()) {
+                failure = "Researcher worker '" + executable + "' could not be launched";
+                return false;
+            }
+            if (writeFrame(toChild, requestBuffer) && readFrame(fromChild, reply, deadline)) return true;
+            if (SteadyClock::now() >= deadline) {
+                failure = "Researcher worker timed out after " + std::to_string(timeout.count()) + " ms and was killed";
+                stop();
+                reply.clear();
+                return false;
+            }
+            std::cerr << "Warning: Researcher worker (pid " << pid << ") stopped responding; restarting it." << std::endl;
+            stop();
+        }
+        failure = "Researcher worker kept crashing (" + std::to_string(maxRestartsPerRequest + 1) + " attempts)";
+        reply.clear();
+        return false;
+    }
+
+    const std::string& lastError() const { return failure; }
+
+    void stop() {
+        if (pid <= 0) return;
+        ::close(toChild); // EOF on stdin asks the worker to exit
+        ::close(fromChild);
+        int status = 0;
+        if (!waitForExit(pid, SteadyClock::now() + std::chrono::milliseconds(200), status)) {
+            ::kill(pid, SIGKILL);
+            waitForExit(pid, SteadyClock::time_point::max(), status);
+        }
+        pid = -1;
+        toChild = -1;
+        fromChild = -1;
+    }
+
+    bool running() const { return pid > 0; }
+    // Number of times the child was spawned; anything above 1 is a restart.
+    int launches() const { return launchCount; }
+
+private:
+    std::string executable;
+    int maxRestartsPerRequest;
+    pid_t pid = -1;
+    int toChild = -1;
+    int fromChild = -1;
+    int launchCount = 0;
+    std::string requestBuffer;
+    std::string failure;
+};
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "program_config.h"
+
+inline uint64_t fnv1a64(std::string_view data, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+inline std::string toHex64(uint64_t value) {
+    char buffer[17];
+    std::snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+    return buffer;
+}
+
+// Identifies a researcher build by content, so a rebuilt binary (for example
+// after a DEBUGGING fix) never sees results produced by the previous one.
+// Falls back to hashing the path when the file cannot be read (PATH lookup).
+inline uint64_t hashExecutable(const std::string& path) {
+    std::string contents;
+    if (!readFile(path, contents)) return fnv1a64(path);
+    return fnv1a64(contents);
+}
+
+struct ResultCacheOptions {
+    std::string directory = ".research_cache";
+    size_t maxMemoryBytes = 16u * 1024u * 1024u;
+    size_t maxMemoryEntries = 1024;
+    size_t maxDiskBytes = 256u * 1024u * 1024u;
+};
+
+struct ResultCacheStats {
+    uint64_t memoryHits = 0;
+    uint64_t diskHits = 0;
+    uint64_t misses = 0;
+    uint64_t stores = 0;
+    uint64_t memoryEvictions = 0;
+    uint64_t diskEvictions = 0;
+};
+
+// Caches researcher output keyed by (researcher binary hash, topic,
+// iteration). An in-memory LRU sits in front of one file per entry under
+// `directory`. Entries record their full key, so a hash collision or a torn
+// file reads as a miss. The disk store evicts the oldest files once it
+// outgrows maxDiskBytes.
+class ResultCache {
+public:
+    ResultCache(uint64_t researcherHash, ResultCacheOptions cacheOptions = ResultCacheOptions())
+        : binaryHex(toHex64(researcherHash)), options(std::move(cacheOptions)) {
+        ::mkdir(options.directory.c_str(), 0755);
+        scanDisk();
+    }
+
+    bool lookup(std::string_view topic, int iteration, std::string& output) {
+        uint64_t key = keyFor(topic, iteration);
+        auto found = index.find(key);
+        if (found != index.end() && found->second->topic == topic && found->second->iteration == iteration) {
+            entries.splice(entries.begin(), entries, found->second);
+            output = found->second->output;
+            ++counters.memoryHits;
+            return true;
+        }
+
+        std::string contents;
+        if (readFile(pathFor(key), contents)) {
+            JsonDocument doc;
+            JsonRef root = doc.parse(contents) ? doc.root() : JsonRef();
+            if (root["binary"].asString() == binaryHex && root["topic"].asString() == topic &&
+                root["iteration"].asInt(-1) == iteration && root["output"].isString()) {
+                output.assign(root["output"].asString());
+                remember(key, topic, iteration, output);
+                ++counters.diskHits;
+                return true;
+            }
+        }
+        ++counters.misses;
+        return false;
+    }
+
+    void store(std::string_view topic, int iteration, std::string_view output) {
+        uint64_t key = keyFor(topic, iteration);
+        remember(key, topic, iteration, output);
+
+        entryBuffer.clear();
+        JsonWriter writer(entryBuffer, false);
+        writer.beginObject();
+        writer.member("binary", binaryHex);
+        writer.member("topic", topic);
+        writer.member("iteration", iteration);
+        writer.member("output", output);
+        writer.endObject();
+
+        // No fsync: losing a cache entry in a crash only costs a recomputation.
+        std::string path = pathFor(key);
+        std::string temp = path + ".tmp";
+        int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return;
+        bool written = ::write(fd, entryBuffer.data(), entryBuffer.size()) == static_cast<ssize_t>(entryBuffer.size());
+        ::close(fd);
+        if (!written || std::rename(temp.c_str(), path.c_str()) != 0) {
+            ::unlink(temp.c_str());
+            return;
+        }
+        ++counters.stores;
+        // An overwrite (after a corrupt entry missed) replaces the old file's
+        // size and moves it to the newest end of the eviction order.
+        forgetDiskFile(path);
+        trackDiskFile(DiskFile{std::move(path), entryBuffer.size()});
+        trimDisk();
+    }
+
+    const ResultCacheStats& stats() const { return counters; }
+    size_t memoryBytes() const { return residentBytes; }
+    size_t diskUsage() const { return diskBytes; }
+
+private:
+    struct Entry {
+        uint64_t key;
+        std::string topic;
+        int iteration;
+        std::string output;
+    };
+
+    struct DiskFile {
+        std::string path;
+        size_t bytes;
+    };
+
+    uint64_t keyFor(std::string_view topic, int iteration) const {
+        uint64_t hash = fnv1a64(binaryHex);
+        hash = fnv1a64(std::string_view("\0", 1), hash);
+        hash = fnv1a64(topic, hash);
+        hash = fnv1a64(std::string_view("\0", 1), hash);
+        return fnv1a64(std::to_string(iteration), hash);
+    }
+
+    std::string pathFor(uint64_t key) const { return options.directory + "/" + toHex64(key) + ".json"; }
+
+    void remember(uint64_t key, std::string_view topic, int iteration, std::string_view output) {
+        auto found = index.find(key);
+        if (found != index.end()) {
+            residentBytes -= found->second->output.size() + found->second->topic.size();
+            entries.erase(found->second);
+            index.erase(found);
+        }
+        if (output.size() + topic.size() > options.maxMemoryBytes) return;
+        entries.push_front(Entry{key, std::string(topic), iteration, std::string(output)});
+        index[key] = entries.begin();
+        residentBytes += output.size() + topic.size();
+        while (!entries.empty() && (residentBytes > options.maxMemoryBytes || entries.size() > options.maxMemoryEntries)) {
+            Entry& victim = entries.back();
+            residentBytes -= victim.output.size() + victim.topic.size();
+            index.erase(victim.key);
+            entries.pop_back();
+            ++counters.memoryEvictions;
+        }
+    }
+
+    // Builds the disk eviction order (oldest modification time first).
+    void scanDisk() {
+        DIR* dir = ::opendir(options.directory.c_str());
+        if (!dir) {
+            std::cerr << "Warning: Result cache directory '" << options.directory << "' is unavailable." << std::endl;
+            return;
+        }
+        std::vector<std::pair<time_t, DiskFile>> found;
+        while (dirent* item = ::readdir(dir)) {
+            std::string_view name = item->d_name;
+            if (name.size() < 5 || name.substr(name.size() - 5) != ".json") continue;
+            std::string path = options.directory + "/" + std::string(name);
+            struct stat info;
+            if (::stat(path.c_str(), &info) != 0) continue;
+            found.push_back({info.st_mtime, DiskFile{path, static_cast<size_t>(info.st_size)}});
+        }
+        ::closedir(dir);
+        std::sort(found.begin(), found.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        for (auto& file : found) trackDiskFile(std::move(file.second));
+        trimDisk();
+    }
+
+    void trackDiskFile(DiskFile file) {
+        diskBytes += file.bytes;
+        diskFiles.push_back(std::move(file));
+        diskIndex[diskFiles.back().path] = std::prev(diskFiles.end());
+    }
+
+    void forgetDiskFile(const std::string& path) {
+        auto found = diskIndex.find(path);
+        if (found == diskIndex.end()) return;
+        diskBytes -= found->second->bytes;
+        diskFiles.erase(found->second);
+        diskIndex.erase(found);
+    }
+
+    void trimDisk() {
+        while (diskBytes > options.maxDiskBytes && !diskFiles.empty()) {
+            DiskFile& oldest = diskFiles.front();
+            ::unlink(oldest.path.c_str());
+            diskBytes -= oldest.bytes;
+            diskIndex.erase(oldest.path);
+            diskFiles.pop_front();
+            ++counters.diskEvictions;
+        }
+    }
+
+    std::string binaryHex;
+    ResultCacheOptions options;
+    std::list<Entry> entries; // most recently used first
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> index;
+    size_t residentBytes = 0;
+    std::list<DiskFile> diskFiles; // oldest first
+    std::unordered_map<std::string, std::list<DiskFile>::iterator> diskIndex;
+    size_t diskBytes = 0;
+    ResultCacheStats counters;
+    std::string entryBuffer;
+};
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "program_config.h"
+
+inline uint32_t crc32(std::string_view data) {
+    struct Table {
+        uint32_t entries[256];
+        constexpr Table() : entries() {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[i] = c;
+            }
+        }
+    };
+    static constexpr Table table;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (char c : data) crc = table.entries[(crc ^ static_cast<unsigned char>(c)) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+struct JournalOptions {
+    int fsyncEveryRecords = 16;                          // batch size for fdatasync
+    std::chrono::milliseconds fsyncInterval{1000};       // ...or sooner if this much time passed
+    int compactEveryRecords = 256;                       // snapshot cadence
+};
+
+// Persists ProgramConfig as a snapshot (`<path>`, the familiar config.json)
+// plus an append-only journal (`<path>.journal`) of per-iteration deltas.
+//
+// Each journal line is "<crc32 hex> <compact JSON>\n". The JSON carries a
+// sequence number and only the fields that changed since the previous
+// record, or every field when "full" is set (first record of a run, and after
+// rebasing onto an earlier iteration). A torn or corrupt tail is detected by
+// its checksum and cut off on open.
+//
+// Compaction rewrites the snapshot atomically together with the journal
+// sequence and byte offset it covers, so load only replays the tail. The
+// journal itself is kept as history: any earlier iteration can be
+// reconstructed by replaying deltas, without storing full copies.
+class StateJournal {
+    using SteadyClock = std::chrono::steady_clock;
+
+public:
+    explicit StateJournal(std::string snapshotFile, JournalOptions journalOptions = JournalOptions())
+        : snapshotPath(std::move(snapshotFile)), journalPath(snapshotPath + ".journal"), options(journalOptions) {}
+
+    ~StateJournal() { close(); }
+
+    StateJournal(const StateJournal&) = delete;
+    StateJournal& operator=(const StateJournal&) = delete;
+
+    // Loads snapshot + journal tail into `config` and opens the journal for
+    // appending. Missing files are not an error; `config` keeps its defaults.
+    bool open(ProgramConfig& config) {
+        uint64_t snapshotSequence = 0;
+        uint64_t snapshotOffset = 0;
+        std::string contents;
+        if (readFile(snapshotPath, contents)) {
+            JsonDocument doc;
+            if (doc.parse(contents) && doc.root().isObject()) {
+                config.fromJson(doc.root());
+                snapshotSequence = static_cast<uint64_t>(doc.root()["journalSequence"].asInt(0));
+                snapshotOffset = static_cast<uint64_t>(doc.root()["journalOffset"].asInt(0));
+            } else {
+                std::cerr << "Warning: Snapshot '" << snapshotPath << "' is not a valid JSON object (" << doc.error() << "). Replaying the journal from the start." << std::endl;
+            }
+        } else {
+            std::cerr << "Warning: Configuration file '" << snapshotPath << "' not found. Using default settings." << std::endl;
+        }
+
+        fd = ::open(journalPath.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open state journal '" << journalPath << "'." << std::endl;
+            return false;
+        }
+        struct stat info;
+        uint64_t size = ::fstat(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+        // Only the tail past the snapshot is read. A journal shorter than the
+        // snapshot's offset was replaced; rescan it.
+        uint64_t start = snapshotOffset <= size ? snapshotOffset : 0;
+        std::string journal(static_cast<size_t>(size - start), '\0');
+        if (!readAt(fd, start, journal)) {
+            std::cerr << "Error: Could not read state journal '" << journalPath << "'." << std::endl;
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        lastSequence = snapshotSequence;
+        uint64_t validEnd = start + replay(journal, 0, [&](uint64_t sequence, JsonRef record) {
+            if (sequence <= snapshotSequence) return;
+            applyRecord(record, config);
+            lastSequence = sequence;
+        });
+        if (validEnd < size) {
+            std::cerr << "Warning: Discarding " << (size - validEnd) << " bytes of torn or corrupt state journal tail." << std::endl;
+            if (::ftruncate(fd, static_cast<off_t>(validEnd)) != 0) {
+                std::cerr << "Error: Could not truncate state journal '" << journalPath << "'." << std::endl;
+            }
+        }
+        journalBytes = validEnd;
+        recorded = config;
+        needFullRecord = true;
+        lastSync = SteadyClock::now();
+        return true;
+    }
+
+    // Appends the fields that changed since the last record. Cheap enough to
+    // call every iteration: one write(), with fsync batched per JournalOptions.
+    bool record(const ProgramConfig& config) {
+        if (!append(config)) return false;
+        if (unsyncedRecords >= options.fsyncEveryRecords || SteadyClock::now() - lastSync >= options.fsyncInterval) sync();
+        if (recordsSinceSnapshot >= options.compactEveryRecords) compact(config);
+        return true;
+    }
+
+    // Forces buffered journal records to stable storage.
+    void sync() {
+        if (fd < 0 || unsyncedRecords == 0) return;
+        ::fdatasync(fd);
+        unsyncedRecords = 0;
+        lastSync = SteadyClock::now();
+    }
+
+    // Writes `config` as the new snapshot, covering everything journaled so far.
+    bool compact(const ProgramConfig& config) {
+        if (!append(config)) return false;
+        sync();
+        snapshotBuffer.clear();
+        JsonWriter writer(snapshotBuffer);
+        writer.beginObject();
+        config.writeFields(writer);
+        writer.member("journalOffset", journalBytes);
+        writer.member("journalSequence", lastSequence);
+        writer.endObject();
+        if (!writeFileAtomically(snapshotPath, snapshotBuffer)) {
+            std::cerr << "Error: Could not write snapshot '" << snapshotPath << "'." << std::endl;
+            return false;
+        }
+        recordsSinceSnapshot = 0;
+        return true;
+    }
+
+    // Reconstructs the state as of the end of `iteration` (the latest run to
+    // reach it, if the journal was rebased) by replaying from the beginning.
+    bool stateAt(int iteration, ProgramConfig& out) const {
+        std::string journal;
+        if (!readFile(journalPath, journal)) return false;
+        ProgramConfig state;
+        bool found = false;
+        replay(journal, 0, [&](uint64_t, JsonRef record) {
+            applyRecord(record, state);
+            if (state.researchIteration == iteration) {
+                out = state;
+                found = true;
+            }
+        });
+        return found;
+    }
+
+    // Continues from `config` (e.g. an earlier iteration from stateAt()); the
+    // next record is written in full so replay does not mix in later deltas.
+    void rebase(const ProgramConfig& config) {
+        recorded = config;
+        needFullRecord = true;
+    }
+
+    void close() {
+        if (fd < 0) return;
+        sync();
+        ::close(fd);
+        fd = -1;
+    }
+
+    const std::string& journalFile() const { return journalPath; }
+    uint64_t sequence() const { return lastSequence; }
+
+private:
+    // Writes one record unless nothing changed. Does not sync or compact.
+    bool append(const ProgramConfig& config) {
+        if (fd < 0) return false;
+        line.clear();
+        line.append(9, ' ');
+        JsonWriter writer(line, false);
+        writer.beginObject();
+        writer.member("seq", lastSequence + 1);
+        size_t changed = 0;
+        if (needFullRecord) {
+            writer.member("full", true);
+            config.writeFields(writer);
+            changed = 1;
+        } else {
+            changed = writeDelta(writer, recorded, config);
+        }
+        writer.endObject();
+        if (changed == 0) return true;
+
+        char checksum[9];
+        std::snprintf(checksum, sizeof(checksum), "%08x", crc32(std::string_view(line).substr(9)));
+        line.replace(0, 8, checksum, 8);
+        line.push_back('\n');
+        if (!writeAll(line)) {
+            std::cerr << "Error: Could not append to state journal '" << journalPath << "'." << std::endl;
+            return false;
+        }
+        journalBytes += line.size();
+        ++lastSequence;
+        ++unsyncedRecords;
+        ++recordsSinceSnapshot;
+        recorded = config;
+        needFullRecord = false;
+        return true;
+    }
+
+    static void applyRecord(JsonRef record, ProgramConfig& config) {
+        if (record["full"].asBool()) config = ProgramConfig();
+        config.fromJson(record);
+    }
+
+    // Calls `fn(sequence, record)` for each intact line from `start`; returns
+    // the offset just past the last intact line.
+    template <typename Fn>
+    static size_t replay(const std::string& journal, size_t start, Fn&& fn) {
+        JsonDocument doc;
+        size_t position = start;
+        while (position < journal.size()) {
+            size_t newline = journal.find('\n', position);
+            if (newline == std::string::npos || newline - position < 10 || journal[position + 8] != ' ') break;
+            std::string_view body(journal.data() + position + 9, newline - position - 9);
+            uint32_t expected = 0;
+            auto parsed = std::from_chars(journal.data() + position, journal.data() + position + 8, expected, 16);
+            if (parsed.ec != std::errc() || expected != crc32(body) || !doc.parse(body)) break;
+            fn(static_cast<uint64_t>(doc.root()["seq"].asInt(0)), doc.root());
+            position = newline + 1;
+        }
+        return position;
+    }
+
+    static size_t writeDelta(JsonWriter& writer, const ProgramConfig& before, const ProgramConfig& after) {
+        size_t changed = 0;
+        if (after.currentPhase != before.currentPhase) { writer.member("currentPhase", phaseToString(after.currentPhase)); ++changed; }
+        if (after.debugAttempts != before.debugAttempts) { writer.member("debugAttempts", after.debugAttempts); ++changed; }
+        if (after.debugMatches != before.debugMatches) {
+            writer.key("debugMatches");
+            ProgramConfig::writeDebugMatches(writer, after.debugMatches);
+            ++changed;
+        }
+        if (after.lastErrorMessage != before.lastErrorMessage) { writer.member("lastErrorMessage", after.lastErrorMessage); ++changed; }
+        if (after.lastResearchSummary != before.lastResearchSummary) { writer.member("lastResearchSummary", after.lastResearchSummary); ++changed; }
+        if (after.llama3SimulatedDownloaded != before.llama3SimulatedDownloaded) { writer.member("llama3SimulatedDownloaded", after.llama3SimulatedDownloaded); ++changed; }
+        if (after.researchComplete != before.researchComplete) { writer.member("researchComplete", after.researchComplete); ++changed; }
+        if (after.researchCompletenessScore != before.researchCompletenessScore) { writer.member("researchCompletenessScore", after.researchCompletenessScore); ++changed; }
+        if (after.researchIteration != before.researchIteration) { writer.member("researchIteration", after.researchIteration); ++changed; }
+        if (after.researchTopic != before.researchTopic) {
+            writer.key("topicLineage");
+            after.researchTopic.write(writer);
+            ++changed;
+        }
+        if (after.validationResults != before.validationResults) {
+            writer.key("validationResults");
+            ProgramConfig::writeValidationResults(writer, after.validationResults);
+            ++changed;
+        }
+        return changed;
+    }
+
+    static bool readAt(int fd, uint64_t offset, std::string& out) {
+        size_t done = 0;
+        while (done < out.size()) {
+            ssize_t got = ::pread(fd, &out[done], out.size() - done, static_cast<off_t>(offset + done));
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) return false;
+            done += static_cast<size_t>(got);
+        }
+        return true;
+    }
+
+    bool writeAll(std::string_view data) {
+        while (!data.empty()) {
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+        return true;
+    }
+
+    std::string snapshotPath;
+    std::string journalPath;
+    JournalOptions options;
+    int fd = -1;
+    uint64_t lastSequence = 0;
+    uint64_t journalBytes = 0;
+    int unsyncedRecords = 0;
+    int recordsSinceSnapshot = 0;
+    bool needFullRecord = true;
+    ProgramConfig recorded;
+    SteadyClock::time_point lastSync;
+    std::string line;
+    std::string snapshotBuffer;
+};
@@ -0,0 +1,82 @@
+// Local stand-in for ./rust_researcher. It produces deterministic results
+// so the orchestrator can be exercised without the real Rust binary.
+//
+//   stub_researcher <topic> <iteration>   one-shot: print one JSON result
+//   stub_researcher --serve               framed request/reply loop on stdin/stdout
+//
+// Environment knobs:
+//   STUB_SUMMARY_BYTES  approximate size of research_summary (default 256)
+//   STUB_ERROR_EVERY    report error_found every N iterations unless the topic
+//                       starts with "fix_" (default 5, 0 disables)
+//   STUB_CRASH_AFTER    in --serve mode, exit abruptly after N requests
+//   STUB_DELAY_MS       sleep this long before answering (simulates a hang)
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "json.h"
+#include "researcher_worker.h"
+
+static long envNumber(const char* name, long fallback) {
+    const char* value = std::getenv(name);
+    return value ? std::strtol(value, nullptr, 10) : fallback;
+}
+
+static void buildResult(std::string_view topic, long long iteration, std::string& out) {
+    long summaryBytes = envNumber("STUB_SUMMARY_BYTES", 256);
+    long errorEvery = envNumber("STUB_ERROR_EVERY", 5);
+    long delayMs = envNumber("STUB_DELAY_MS", 0);
+    if (delayMs > 0) std::this_thread::sleep_for(std::chrono::milliseconds(delayMs));
+    bool fixing = topic.compare(0, 4, "fix_") == 0;
+    bool errorFound = errorEvery > 0 && iteration % errorEvery == 0 && !fixing;
+
+    std::string summary = "Findings for '" + std::string(topic) + "' at iteration " + std::to_string(iteration) + ": ";
+    static const char filler[] = "cross-validated evidence, \"quoted\" sources: {n=42}; ";
+    while (static_cast<long>(summary.size()) < summaryBytes) summary += filler;
+
+    double score = 10.0 * static_cast<double>(iteration) + static_cast<double>(topic.size() % 7);
+    if (score > 100.0) score = 100.0;
+
+    out.clear();
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.member("research_summary", summary);
+    writer.member("research_completeness_score", score);
+    writer.member("error_found", errorFound);
+    writer.member("error_message", errorFound ? "stub researcher: simulated data inconsistency" : "None");
+    writer.endObject();
+}
+
+static int serve() {
+    long crashAfter = envNumber("STUB_CRASH_AFTER", 0);
+    long served = 0;
+    std::string request;
+    std::string reply;
+    JsonDocument doc;
+    while (readFrame(STDIN_FILENO, request)) {
+        if (crashAfter > 0 && served >= crashAfter) std::_Exit(3);
+        if (!doc.parse(request)) {
+            reply = "{\"error_found\": true, \"error_message\": \"stub researcher: malformed request\"}";
+        } else {
+            buildResult(doc.root()["topic"].asString(), doc.root()["iteration"].asInt(), reply);
+        }
+        if (!writeFrame(STDOUT_FILENO, reply)) return 1;
+        ++served;
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 2 && std::string_view(argv[1]) == "--serve") return serve();
+    if (argc != 3) {
+        std::cerr << "usage: " << argv[0] << " <topic> <iteration> | --serve" << std::endl;
+        return 2;
+    }
+    std::string out;
+    buildResult(argv[1], std::strtoll(argv[2], nullptr, 10), out);
+    std::cout << out << std::endl;
+    return 0;
+}
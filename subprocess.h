@@ -0,0 +1,332 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using SteadyClock = std::chrono::steady_clock;
+
+// Deadline helpers: a zero timeout means "wait forever", represented by
+// time_point::max() so callers never special-case it.
+inline SteadyClock::time_point deadlineAfter(std::chrono::milliseconds timeout) {
+    return timeout.count() > 0 ? SteadyClock::now() + timeout : SteadyClock::time_point::max();
+}
+
+// Milliseconds until `deadline` in the form poll() expects: -1 for no deadline.
+inline int pollTimeoutMs(SteadyClock::time_point deadline) {
+    if (deadline == SteadyClock::time_point::max()) return -1;
+    auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - SteadyClock::now()).count();
+    return remaining > 0 ? static_cast<int>(std::min<long long>(remaining, 1 << 30)) : 0;
+}
+
+// Starts argv[0] (searched on PATH) without a shell. Each child descriptor
+// argument that is >= 0 is installed as the child's stdin/stdout/stderr;
+// -1 inherits ours. With `ownProcessGroup` the child leads a new process
+// group so a timeout can kill anything it started. Returns -1 on failure.
+inline pid_t spawnProcess(const std::vector<std::string>& argv, int childStdin, int childStdout, int childStderr,
+                          bool ownProcessGroup) {
+    if (argv.empty()) return -1;
+    std::vector<char*> args;
+    args.reserve(argv.size() + 1);
+    for (const std::string& arg : argv) args.push_back(const_cast<char*>(arg.c_str()));
+    args.push_back(nullptr);
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (childStdin >= 0) posix_spawn_file_actions_adddup2(&actions, childStdin, STDIN_FILENO);
+    if (childStdout >= 0) posix_spawn_file_actions_adddup2(&actions, childStdout, STDOUT_FILENO);
+    if (childStderr >= 0) posix_spawn_file_actions_adddup2(&actions, childStderr, STDERR_FILENO);
+
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    if (ownProcessGroup) {
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attributes, 0);
+    }
+
+    pid_t pid = -1;
+    int rc = posix_spawnp(&pid, args[0], &actions, &attributes, args.data(), environ);
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&actions);
+    return rc == 0 ? pid : -1;
+}
+
+// Waits for `pid` until `deadline`. Returns false if it is still running.
+inline bool waitForExit(pid_t pid, SteadyClock::time_point deadline, int& status) {
+    if (deadline == SteadyClock::time_point::max()) {
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) return true;
+        }
+        return true;
+    }
+    auto nap = std::chrono::microseconds(100);
+    while (true) {
+        pid_t rc = waitpid(pid, &status, WNOHANG);
+        if (rc == pid || (rc < 0 && errno != EINTR)) return true;
+        if (SteadyClock::now() >= deadline) return false;
+        std::this_thread::sleep_for(nap);
+        nap = std::min(nap * 2, std::chrono::microseconds(10000));
+    }
+}
+
+struct SubprocessOptions {
+    std::chrono::milliseconds timeout{0};  // 0 waits indefinitely
+    size_t reserveBytes = 64 * 1024;        // initial stdout capacity
+    size_t readChunkBytes = 64 * 1024;      // bytes requested per read()
+    // Called after every stdout read with everything received so far. The
+    // buffer may move on later reads, so copy anything that must outlive the call.
+    std::function<void(const std::string& output)> onOutput;
+    // Checked at least every 50 ms; once it reads true the child is killed
+    // as on a timeout and `result.cancelled` is set instead.
+    const std::atomic<bool>* cancel = nullptr;
+};
+
+struct SubprocessResult {
+    bool launched = false;
+    bool timedOut = false;
+    bool cancelled = false;
+    int exitCode = -1;   // -1 when the child was terminated by a signal
+    int termSignal = 0;
+    std::string output;
+    std::string errors;
+    SteadyClock::duration elapsed{};
+
+    bool succeeded() const { return launched && !timedOut && !cancelled && exitCode == 0; }
+
+    std::string describeFailure(const std::string& what) const {
+        if (!launched) return what + " could not be launched";
+        if (cancelled) return what + " was cancelled";
+        if (timedOut) {
+            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+            return what + " timed out after " + std::to_string(ms) + " ms and was killed";
+        }
+        if (termSignal != 0) return what + " was killed by signal " + std::to_string(termSignal);
+        if (exitCode != 0) return what + " exited with status " + std::to_string(exitCode);
+        return "None";
+    }
+};
+
+namespace subprocess_detail {
+
+// Drains a non-blocking descriptor into `sink`. Returns false at EOF or error.
+inline bool drain(int fd, std::string& sink, size_t chunk) {
+    while (true) {
+        size_t old = sink.size();
+        if (sink.capacity() - old < chunk) sink.reserve(std::max(sink.capacity() * 2, old + chunk));
+        sink.resize(old + chunk);
+        ssize_t got = ::read(fd, &sink[old], chunk);
+        sink.resize(old + (got > 0 ? static_cast<size_t>(got) : 0));
+        if (got > 0) continue;
+        if (got < 0 && errno == EINTR) continue;
+        return got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+} // namespace subprocess_detail
+
+// Runs `argv` to completion, capturing stdout and stderr separately through
+// poll(). When `options.timeout` expires the child's process group is killed
+// and `result.timedOut` is set. `result` buffers are reused between calls.
+inline bool runSubprocess(const std::vector<std::string>& argv, const SubprocessOptions& options,
+                          SubprocessResult& result) {
+    result.launched = false;
+    result.timedOut = false;
+    result.cancelled = false;
+    result.exitCode = -1;
+    result.termSignal = 0;
+    result.output.clear();
+    result.errors.clear();
+    auto started = SteadyClock::now();
+    auto deadline = deadlineAfter(options.timeout);
+
+    int outPipe[2];
+    int errPipe[2];
+    if (pipe2(outPipe, O_CLOEXEC) != 0) return false;
+    if (pipe2(errPipe, O_CLOEXEC) != 0) {
+        ::close(outPipe[0]);
+        ::close(outPipe[1]);
+        return false;
+    }
+    pid_t pid = spawnProcess(argv, -1, outPipe[1], errPipe[1], true);
+    ::close(outPipe[1]);
+    ::close(errPipe[1]);
+    if (pid < 0) {
+        ::close(outPipe[0]);
+        ::close(errPipe[0]);
+        result.elapsed = SteadyClock::now() - started;
+        return false;
+    }
+    result.launched = true;
+    fcntl(outPipe[0], F_SETFL, fcntl(outPipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(errPipe[0], F_SETFL, fcntl(errPipe[0], F_GETFL) | O_NONBLOCK);
+    if (result.output.capacity() < options.reserveBytes) result.output.reserve(options.reserveBytes);
+
+    pollfd fds[2] = {{outPipe[0], POLLIN, 0}, {errPipe[0], POLLIN, 0}};
+    std::string* sinks[2] = {&result.output, &result.errors};
+    int open = 2;
+    while (open > 0) {
+        int waitMs = pollTimeoutMs(deadline);
+        if (waitMs == 0) {
+            result.timedOut = true;
+            break;
+        }
+        if (options.cancel) {
+            if (options.cancel->load(std::memory_order_relaxed)) {
+                result.cancelled = true;
+                break;
+            }
+            if (waitMs < 0 || waitMs > 50) waitMs = 50;
+        }
+        int ready = poll(fds, 2, waitMs);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < 2; ++i) {
+            if (fds[i].fd < 0 || fds[i].revents == 0) continue;
+            size_t before = sinks[i]->size();
+            bool stillOpen = subprocess_detail::drain(fds[i].fd, *sinks[i], options.readChunkBytes);
+            if (i == 0 && options.onOutput && result.output.size() != before) options.onOutput(result.output);
+            if (!stillOpen) {
+                ::close(fds[i].fd);
+                fds[i].fd = -1;
+                --open;
+            }
+        }
+    }
+    for (pollfd& entry : fds) {
+        if (entry.fd >= 0) ::close(entry.fd);
+    }
+
+    int status = 0;
+    if (result.timedOut || result.cancelled || !waitForExit(pid, deadline, status)) {
+        if (!result.cancelled) result.timedOut = true;
+        ::kill(-pid, SIGKILL);
+        waitForExit(pid, SteadyClock::time_point::max(), status);
+    }
+    if (WIFEXITED(status)) result.exitCode = WEXITSTATUS(status);
+    else if (WIFSIGNALED(status)) result.termSignal = WTERMSIG(status);
+    result.elapsed = SteadyClock::now() - started;
+    return true;
+}
+
+// Non-blocking counterpart of runSubprocess for callers that multiplex many
+// children on their own poll/epoll loop: start() launches the child, the
+// caller watches outputFd()/errorFd() and calls readReady() when either is
+// readable, then tryReap() until the child has exited (or kill() at its
+// deadline). Results land in the SubprocessResult passed to start().
+class AsyncSubprocess {
+public:
+    AsyncSubprocess() = default;
+    AsyncSubprocess(const AsyncSubprocess&) = delete;
+    AsyncSubprocess& operator=(const AsyncSubprocess&) = delete;
+    ~AsyncSubprocess() {
+        if (pid > 0) {
+            kill();
+            tryReap();
+        }
+        closePipes();
+    }
+
+    bool start(const std::vector<std::string>& argv, SubprocessResult& target, size_t reserveBytes = 64 * 1024) {
+        result = &target;
+        result->launched = false;
+        result->timedOut = false;
+        result->cancelled = false;
+        result->exitCode = -1;
+        result->termSignal = 0;
+        result->output.clear();
+        result->errors.clear();
+        started = SteadyClock::now();
+
+        int outPipe[2];
+        int errPipe[2];
+        if (pipe2(outPipe, O_CLOEXEC) != 0) return false;
+        if (pipe2(errPipe, O_CLOEXEC) != 0) {
+            ::close(outPipe[0]);
+            ::close(outPipe[1]);
+            return false;
+        }
+        pid = spawnProcess(argv, -1, outPipe[1], errPipe[1], true);
+        ::close(outPipe[1]);
+        ::close(errPipe[1]);
+        if (pid < 0) {
+            ::close(outPipe[0]);
+            ::close(errPipe[0]);
+            result->elapsed = SteadyClock::now() - started;
+            return false;
+        }
+        result->launched = true;
+        fds[0] = outPipe[0];
+        fds[1] = errPipe[0];
+        for (int fd : fds) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        if (result->output.capacity() < reserveBytes) result->output.reserve(reserveBytes);
+        return true;
+    }
+
+    int outputFd() const { return fds[0]; }
+    int errorFd() const { return fds[1]; }
+    bool pipesOpen() const { return fds[0] >= 0 || fds[1] >= 0; }
+    bool running() const { return pid > 0; }
+
+    // Drains `fd` (one of the two pipes); closes it at EOF.
+    void readReady(int fd, size_t chunk = 64 * 1024) {
+        for (int i = 0; i < 2; ++i) {
+            if (fds[i] != fd || fd < 0) continue;
+            if (!subprocess_detail::drain(fd, i == 0 ? result->output : result->errors, chunk)) {
+                ::close(fd);
+                fds[i] = -1;
+            }
+        }
+    }
+
+    // Kills the child's process group; the next tryReap() reports a timeout.
+    void kill() {
+        if (pid <= 0) return;
+        result->timedOut = true;
+        ::kill(-pid, SIGKILL);
+    }
+
+    // Returns true once the child has exited and its status is recorded.
+    bool tryReap() {
+        if (pid <= 0) return true;
+        int status = 0;
+        pid_t rc = waitpid(pid, &status, result->timedOut ? 0 : WNOHANG);
+        if (rc == 0 || (rc < 0 && errno == EINTR)) return false;
+        if (rc == pid) {
+            if (WIFEXITED(status)) result->exitCode = WEXITSTATUS(status);
+            else if (WIFSIGNALED(status)) result->termSignal = WTERMSIG(status);
+        }
+        pid = -1;
+        closePipes();
+        result->elapsed = SteadyClock::now() - started;
+        return true;
+    }
+
+private:
+    void closePipes() {
+        for (int& fd : fds) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+    }
+
+    SubprocessResult* result = nullptr;
+    pid_t pid = -1;
+    int fds[2] = {-1, -1};
+    SteadyClock::time_point started;
+};
@@ -0,0 +1,1760 @@
+#include <iostream>
+#include <string>
+#include <map>
+#include <sstream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <functional>
+#include <fstream>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "json.h"
+#include "qa_server.h"
+#include "research_daemon.h"
+#include "research_session.h"
+#include "researcher_worker.h"
+#include "subprocess.h"
+#include "work_pool.h"
+#include "program_config.h"
+#include "state_journal.h"
+#include "pacing.h"
+#include "phase_simulator.h"
+#include "research_topic.h"
+#include "debug_scanner.h"
+#include "validation_runner.h"
+#include "result_cache.h"
+#include "knowledge_base.h"
+#include "logger.h"
+#include "metrics.h"
+
+// Original main.cpp implementations, kept verbatim as the benchmark baseline.
+std::map<std::string, std::string> legacyParseJson(const std::string& jsonString) {
+    std::map<std::string, std::string> data;
+    std::string cleanString = jsonString;
+    cleanString.erase(std::remove(cleanString.begin(), cleanString.end(), '{'), cleanString.end());
+    cleanString.erase(std::remove(cleanString.begin(), cleanString.end(), '}'), cleanString.end());
+    cleanString.erase(std::remove(cleanString.begin(), cleanString.end(), '"'), cleanString.end());
+
+    std::stringstream ss(cleanString);
+    std::string segment;
+    while (std::getline(ss, segment, ',')) {
+        std::stringstream ssSegment(segment);
+        std::string key, value;
+        if (std::getline(ssSegment, key, ':')) {
+            if (std::getline(ssSegment, value)) {
+                key.erase(0, key.find_first_not_of(" \t\n\r\f\v"));
+                key.erase(key.find_last_not_of(" \t\n\r\f\v") + 1);
+                value.erase(0, value.find_first_not_of(" \t\n\r\f\v"));
+                value.erase(value.find_last_not_of(" \t\n\r\f\v") + 1);
+                data[key] = value;
+            }
+        }
+    }
+    return data;
+}
+
+std::string legacyToJsonString(const std::map<std::string, std::string>& data) {
+    std::string json = "{\n";
+    bool first = true;
+    for (const auto& pair : data) {
+        if (!first) {
+            json += ",\n";
+        }
+        json += "    \"" + pair.first + "\": \"" + pair.second + "\"";
+        first = false;
+    }
+    json += "\n}";
+    return json;
+}
+
+// Deterministic prose with the punctuation that trips the legacy parser.
+std::string makeSummaryText(size_t bytes, unsigned seed) {
+    static const char* words[] = {
+        "entropy", "gradient", "lattice", "photovoltaic", "storage,", "grid:", "{model}",
+        "\"quoted\"", "throughput", "baseline", "regression", "C:\\data", "iteration", "hypothesis"
+    };
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<size_t> pick(0, sizeof(words) / sizeof(words[0]) - 1);
+    std::string text;
+    text.reserve(bytes + 16);
+    while (text.size() < bytes) {
+        text += words[pick(gen)];
+        text += (gen() % 7 == 0) ? "\n" : " ";
+    }
+    return text;
+}
+
+// A researcher reply of roughly `bytes` bytes, shaped like rust_researcher output.
+std::string makeResearcherOutput(size_t bytes, unsigned seed) {
+    std::string out;
+    JsonWriter writer(out);
+    writer.beginObject();
+    writer.member("research_summary", makeSummaryText(bytes, seed));
+    writer.member("research_completeness_score", 87.5);
+    writer.member("error_found", false);
+    writer.member("error_message", "None");
+    writer.key("sources");
+    writer.beginArray();
+    for (int i = 0; i < 8; ++i) {
+        writer.beginObject();
+        writer.member("url", "https://example.org/paper/" + std::to_string(i));
+        writer.member("relevance", 0.1 * i);
+        writer.endObject();
+    }
+    writer.endArray();
+    writer.endObject();
+    return out;
+}
+
+std::string legacyExecCommand(const char* cmd) {
+    std::string result = "";
+    FILE* pipe = popen(cmd, "r");
+    if (!pipe) {
+        std::cerr << "Error: popen() failed!" << std::endl;
+        return "";
+    }
+    char buffer[128];
+    while (!feof(pipe)) {
+        if (fgets(buffer, 128, pipe) != nullptr) {
+            result += buffer;
+        }
+    }
+    pclose(pipe);
+    return result;
+}
+
+std::string legacyReplaceAll(std::string str, const std::string& from, const std::string& to) {
+    size_t start_pos = 0;
+    while((start_pos = str.find(from, start_pos)) != std::string::npos) {
+        str.replace(start_pos, from.length(), to);
+        start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+    }
+    return str;
+}
+
+// Original ProgramConfig::load/save bodies on top of the legacy JSON helpers.
+bool legacyLoadConfig(const std::string& filename, ProgramConfig& config) {
+    std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    file.close();
+    std::map<std::string, std::string> data = legacyParseJson(buffer.str());
+
+    if (data.count("researchTopic")) config.researchTopic = ResearchTopic::fromLegacy(data["researchTopic"]);
+    if (data.count("researchIteration")) config.researchIteration = std::stoi(data["researchIteration"]);
+    if (data.count("researchComplete")) config.researchComplete = (data["researchComplete"] == "true");
+    if (data.count("lastResearchSummary")) config.lastResearchSummary = data["lastResearchSummary"];
+    if (data.count("lastErrorMessage")) config.lastErrorMessage = data["lastErrorMessage"];
+    if (data.count("llama3SimulatedDownloaded")) config.llama3SimulatedDownloaded = (data["llama3SimulatedDownloaded"] == "true");
+    if (data.count("debugAttempts")) config.debugAttempts = std::stoi(data["debugAttempts"]);
+    if (data.count("researchCompletenessScore")) config.researchCompletenessScore = std::stod(data["researchCompletenessScore"]);
+    if (data.count("currentPhase")) phaseFromString(data["currentPhase"], config.currentPhase);
+    return true;
+}
+
+bool legacySaveConfig(const std::string& filename, const ProgramConfig& config) {
+    std::ofstream file(filename);
+    if (!file.is_open()) return false;
+    std::map<std::string, std::string> data;
+    data["researchTopic"] = config.researchTopic.legacy();
+    data["researchIteration"] = std::to_string(config.researchIteration);
+    data["researchComplete"] = config.researchComplete ? "true" : "false";
+    data["lastResearchSummary"] = config.lastResearchSummary;
+    data["lastErrorMessage"] = config.lastErrorMessage;
+    data["llama3SimulatedDownloaded"] = config.llama3SimulatedDownloaded ? "true" : "false";
+    data["debugAttempts"] = std::to_string(config.debugAttempts);
+    data["researchCompletenessScore"] = std::to_string(config.researchCompletenessScore);
+    data["currentPhase"] = phaseToString(config.currentPhase);
+    file << legacyToJsonString(data);
+    file.close();
+    return true;
+}
+
+struct BenchResult {
+    std::string group;
+    std::string name;
+    int repetitions;
+    double meanNs;
+    double minNs;
+    double medianNs;
+    double p90Ns;
+    double p99Ns;
+    double maxNs;
+};
+
+// Set by each bench function and recorded with its results.
+std::string benchGroup;
+std::vector<BenchResult> benchResults;
+
+BenchResult runBench(const std::string& name, int warmup, int repetitions, const std::function<void()>& body) {
+    for (int i = 0; i < warmup; ++i) body();
+    std::vector<double> samples;
+    samples.reserve(repetitions);
+    for (int i = 0; i < repetitions; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double q) { return samples[static_cast<size_t>(q * static_cast<double>(samples.size() - 1) + 0.5)]; };
+    double total = 0.0;
+    for (double sample : samples) total += sample;
+    BenchResult result{benchGroup, name, repetitions, total / static_cast<double>(samples.size()), samples.front(),
+                       percentile(0.5), percentile(0.9), percentile(0.99), samples.back()};
+    std::cout << "  " << name << ": median " << result.medianNs / 1000.0 << " us, p90 " << result.p90Ns / 1000.0
+              << " us, p99 " << result.p99Ns / 1000.0 << " us, min " << result.minNs / 1000.0 << " us" << std::endl;
+    benchResults.push_back(result);
+    return result;
+}
+
+// One JSON object per line, so two runs can be diffed or loaded by a script.
+bool writeBenchResults(const std::string& path) {
+    std::string out;
+    for (const BenchResult& result : benchResults) {
+        JsonWriter writer(out, false);
+        writer.beginObject();
+        writer.member("group", result.group);
+        writer.member("name", result.name);
+        writer.member("repetitions", result.repetitions);
+        writer.member("meanNs", result.meanNs);
+        writer.member("minNs", result.minNs);
+        writer.member("medianNs", result.medianNs);
+        writer.member("p90Ns", result.p90Ns);
+        writer.member("p99Ns", result.p99Ns);
+        writer.member("maxNs", result.maxNs);
+        writer.endObject();
+        out.push_back('\n');
+    }
+    return writeFileAtomically(path, out);
+}
+
+int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        ++failures;
+    }
+}
+
+void benchJson() {
+    std::cout << "--- JSON engine vs legacy parseJson/toJsonString ---" << std::endl;
+    for (size_t size : {1024u, 8192u, 65536u}) {
+        std::string output = makeResearcherOutput(size, 42);
+        std::string expectedSummary = makeSummaryText(size, 42);
+
+        JsonDocument doc;
+        check(doc.parse(output), "parse researcher output (" + doc.error() + ")");
+        check(doc.root()["research_summary"].asString() == expectedSummary, "summary survives round trip");
+        check(doc.root()["research_completeness_score"].asNumber() == 87.5, "score parsed as number");
+        check(doc.root()["sources"].size() == 8, "nested array parsed");
+        bool legacyIntact = legacyParseJson(output)["research_summary"] == expectedSummary;
+        benchGroup = "json " + std::to_string(output.size()) + "B";
+        std::cout << " " << output.size() << " byte researcher output (legacy summary "
+                  << (legacyIntact ? "intact" : "corrupted") << ")" << std::endl;
+
+        int reps = size > 16384 ? 200 : 2000;
+        volatile size_t sink = 0;
+        runBench("legacy parseJson", reps / 10, reps, [&] {
+            sink = sink + legacyParseJson(output).size();
+        });
+        runBench("JsonDocument::parse (reused)", reps / 10, reps, [&] {
+            doc.parse(output);
+            sink = sink + doc.root()["research_summary"].asString().size();
+        });
+
+        std::map<std::string, std::string> fields{{"research_summary", expectedSummary},
+                                                  {"researchTopic", "deepen_general_knowledge"},
+                                                  {"researchIteration", "12"}};
+        std::string buffer;
+        runBench("legacy toJsonString", reps / 10, reps, [&] {
+            sink = sink + legacyToJsonString(fields).size();
+        });
+        runBench("JsonWriter (reused buffer)", reps / 10, reps, [&] {
+            buffer.clear();
+            JsonWriter writer(buffer);
+            writer.beginObject();
+            for (const auto& field : fields) writer.member(field.first, field.second);
+            writer.endObject();
+            sink = sink + buffer.size();
+        });
+        check(doc.parse(buffer) && doc.root()["research_summary"].asString() == expectedSummary, "writer output re-parses");
+    }
+}
+
+void testJsonEdgeCases() {
+    JsonDocument doc;
+    check(doc.parse("{\"a\": \"\\u00e9\\ud83d\\ude00\\n\", \"b\": [1, -2.5e3, true, null, {}], \"c\": {\"d\": []}}"), "edge case document");
+    check(doc.root()["a"].asString() == "\xC3\xA9\xF0\x9F\x98\x80\n", "unicode escapes decode to UTF-8");
+    check(doc.root()["b"].at(1).asNumber() == -2500.0, "exponent number");
+    check(doc.root()["b"].at(4).isObject() && doc.root()["b"].at(4).size() == 0, "empty object element");
+    check(doc.root()["c"]["d"].isArray(), "nested lookup");
+    check(!doc.root()["missing"]["deeper"].valid(), "missing keys chain to invalid");
+    check(!doc.parse("{\"a\": 01}"), "leading zero rejected");
+    check(!doc.parse("{\"a\": \"unterminated}"), "unterminated string rejected");
+    check(!doc.parse("{\"a\": 1} trailing"), "trailing garbage rejected");
+}
+
+void testFraming() {
+    int fds[2];
+    check(pipe(fds) == 0, "pipe for framing test");
+    std::string payload = "{\"topic\": \"a\\u0000b\", \"iteration\": 3}";
+    check(writeFrame(fds[1], payload) && writeFrame(fds[1], ""), "write frames");
+    ::close(fds[1]);
+    std::string got;
+    check(readFrame(fds[0], got) && got == payload, "frame payload round trip");
+    check(readFrame(fds[0], got) && got.empty(), "empty frame round trip");
+    check(!readFrame(fds[0], got), "EOF reported after last frame");
+    ::close(fds[0]);
+}
+
+void testResearcherWorker(const std::string& stubPath) {
+    std::cout << "--- Persistent researcher worker ---" << std::endl;
+    benchGroup = "researcher worker";
+    std::string reply;
+    JsonDocument doc;
+    {
+        ResearcherWorker worker(stubPath);
+        check(worker.request("general_knowledge", 4, reply), "worker request");
+        check(doc.parse(reply) && doc.root()["research_completeness_score"].asNumber() == 43.0, "worker reply parsed");
+        check(worker.request("fix_general_knowledge", 5, reply) && doc.parse(reply) && !doc.root()["error_found"].asBool(), "second request on same process");
+        check(worker.launches() == 1, "worker launched once");
+    }
+
+    setenv("STUB_CRASH_AFTER", "2", 1);
+    {
+        ResearcherWorker worker(stubPath);
+        bool allAnswered = true;
+        for (int i = 1; i <= 7; ++i) {
+            allAnswered = worker.request("general_knowledge", i, reply) && doc.parse(reply) && allAnswered;
+        }
+        check(allAnswered, "every request answered across worker crashes");
+        check(worker.launches() == 4, "worker restarted after each crash");
+    }
+    unsetenv("STUB_CRASH_AFTER");
+
+    int reps = 200;
+    std::string command = stubPath + " \"general_knowledge\" 7";
+    volatile size_t sink = 0;
+    runBench("one-shot popen per iteration", 10, reps, [&] {
+        sink = sink + legacyExecCommand(command.c_str()).size();
+    });
+    ResearcherWorker worker(stubPath);
+    runBench("persistent worker round trip", 10, reps, [&] {
+        worker.request("general_knowledge", 7, reply);
+        sink = sink + reply.size();
+    });
+}
+
+void testSubprocess() {
+    SubprocessOptions options;
+    SubprocessResult result;
+    check(runSubprocess({"sh", "-c", "echo out; echo err >&2; exit 3"}, options, result), "spawn sh");
+    check(result.output == "out\n" && result.errors == "err\n", "stdout and stderr captured separately");
+    check(result.exitCode == 3 && !result.succeeded(), "exit status reported");
+
+    check(!runSubprocess({"/nonexistent/researcher"}, options, result) && !result.launched, "launch failure reported");
+
+    options.timeout = std::chrono::milliseconds(100);
+    check(runSubprocess({"sleep", "5"}, options, result) && result.timedOut, "hung child times out");
+    check(result.elapsed < std::chrono::seconds(2), "timed out child killed promptly");
+    check(result.describeFailure("sleep").find("timed out") != std::string::npos, "timeout described");
+
+    // The object must reach the parser while the child is still running.
+    options.timeout = std::chrono::milliseconds(0);
+    JsonStreamScanner scanner;
+    JsonDocument doc;
+    std::string payload;
+    SteadyClock::time_point parsedAt{};
+    options.onOutput = [&](const std::string& received) {
+        if (!scanner.complete() && scanner.feed(received)) {
+            payload.assign(scanner.object(received));
+            if (doc.parse(payload)) parsedAt = SteadyClock::now();
+        }
+    };
+    check(runSubprocess({"sh", "-c", "echo 'log: {not json'; echo '{\"a\": \"}\", \"b\": [1]}'; sleep 0.3"}, options, result), "spawn streaming child");
+    check(parsedAt != SteadyClock::time_point{} && SteadyClock::now() - parsedAt > std::chrono::milliseconds(200), "JSON handed to parser before EOF");
+    check(doc.root()["a"].asString() == "}" && doc.root()["b"].size() == 1, "streamed object parsed");
+}
+
+void testWorkerTimeout(const std::string& stubPath) {
+    setenv("STUB_DELAY_MS", "1000", 1);
+    ResearcherWorker worker(stubPath);
+    std::string reply;
+    auto started = SteadyClock::now();
+    check(!worker.request("general_knowledge", 1, reply, std::chrono::milliseconds(100)), "slow worker request fails");
+    check(SteadyClock::now() - started < std::chrono::milliseconds(800), "worker timeout honoured");
+    check(worker.lastError().find("timed out") != std::string::npos && !worker.running(), "hung worker killed");
+    unsetenv("STUB_DELAY_MS");
+    check(worker.request("general_knowledge", 1, reply), "worker restarted after timeout");
+}
+
+void benchSubprocess(const std::string& stubPath) {
+    std::cout << "--- Subprocess capture (4 MB researcher output) ---" << std::endl;
+    benchGroup = "subprocess 4MB";
+    setenv("STUB_SUMMARY_BYTES", "4194304", 1);
+    std::string command = stubPath + " general_knowledge 7";
+    volatile size_t sink = 0;
+    runBench("legacy popen/fgets(128)", 2, 20, [&] {
+        sink = sink + legacyExecCommand(command.c_str()).size();
+    });
+    SubprocessOptions options;
+    SubprocessResult result;
+    runBench("runSubprocess (64 KB reads)", 2, 20, [&] {
+        runSubprocess({stubPath, "general_knowledge", "7"}, options, result);
+        sink = sink + result.output.size();
+    });
+    unsetenv("STUB_SUMMARY_BYTES");
+}
+
+std::string makeTempDir() {
+    char pattern[] = "/tmp/deepresearch_test_XXXXXX";
+    const char* dir = mkdtemp(pattern);
+    return dir ? dir : "/tmp";
+}
+
+void benchFanOut(const std::string& stubPath) {
+    std::cout << "--- Subtopic fan-out ---" << std::endl;
+    benchGroup = "fanout";
+    setenv("STUB_DELAY_MS", "20", 1);
+    setenv("STUB_ERROR_EVERY", "0", 1);
+    LoggerOptions quiet;
+    quiet.consoleLevel = LogLevel::ERROR;
+    Logger logger(quiet);
+    MetricsRegistry registry;
+    OrchestratorMetrics metrics(registry);
+    for (size_t shards : {1, 8}) {
+        std::string dir = makeTempDir();
+        OrchestratorOptions options;
+        options.researcherPath = stubPath;
+        options.pacer = Pacer(PacingMode::VIRTUAL);
+        options.fanout = shards;
+        WorkStealingPool pool(shards);
+        {
+            ResearchSession session("bench", dir, options, logger, metrics, 1);
+            session.openState();
+            session.openKnowledge();
+            session.useFanOut(&pool);
+            runBench("research cycle, " + std::to_string(shards) + " subtopic(s), 20 ms researcher", 1, 10, [&] {
+                session.config().currentPhase = ProgramPhase::RESEARCH_CYCLE;
+                session.config().researchIteration = 0;
+                session.step();
+            });
+        }
+        std::system(("rm -rf " + dir).c_str());
+    }
+    unsetenv("STUB_DELAY_MS");
+    unsetenv("STUB_ERROR_EVERY");
+}
+
+void advance(ProgramConfig& config, int iteration) {
+    config.researchIteration = iteration;
+    config.currentPhase = iteration % 3 == 0 ? ProgramPhase::DEBUGGING : ProgramPhase::RESEARCH_CYCLE;
+    config.researchCompletenessScore = iteration * 7.5;
+    config.lastResearchSummary = "summary, with: \"punctuation\" #" + std::to_string(iteration);
+}
+
+void testStateJournal() {
+    std::string dir = makeTempDir();
+    std::string snapshot = dir + "/config.json";
+    JournalOptions options;
+    options.compactEveryRecords = 4;
+
+    ProgramConfig expected;
+    {
+        StateJournal journal(snapshot, options);
+        ProgramConfig config;
+        check(journal.open(config), "open empty journal");
+        for (int i = 1; i <= 10; ++i) {
+            advance(config, i);
+            check(journal.record(config), "record iteration");
+        }
+        expected = config;
+    }
+    ProgramConfig reloaded;
+    {
+        StateJournal journal(snapshot, options);
+        check(journal.open(reloaded), "reopen journal");
+        check(reloaded.researchIteration == 10 && reloaded.lastResearchSummary == expected.lastResearchSummary &&
+              reloaded.currentPhase == expected.currentPhase, "snapshot + journal replay restores latest state");
+
+        ProgramConfig earlier;
+        check(journal.stateAt(3, earlier) && earlier.currentPhase == ProgramPhase::DEBUGGING &&
+              earlier.researchCompletenessScore == 22.5, "earlier iteration reconstructed from deltas");
+        check(!journal.stateAt(42, earlier), "unknown iteration reported");
+
+        journal.rebase(earlier);
+        advance(earlier, 4);
+        earlier.researchTopic = ResearchTopic("rewound");
+        earlier.researchTopic.push(TopicOp::FIX);
+        journal.record(earlier);
+    }
+    {
+        StateJournal journal(snapshot, options);
+        ProgramConfig config;
+        journal.open(config);
+        check(config.researchIteration == 4 && config.researchTopic.legacy() == "fix_rewound", "rebased history wins on replay");
+    }
+
+    // Simulate a crash mid-append: the torn record must be ignored and cut off.
+    {
+        int fd = ::open((snapshot + ".journal").c_str(), O_WRONLY | O_APPEND);
+        const char torn[] = "deadbeef {\"seq\":999,\"researchIteration\":77";
+        check(::write(fd, torn, sizeof(torn) - 1) > 0, "append torn record");
+        ::close(fd);
+        StateJournal journal(snapshot, options);
+        ProgramConfig config;
+        journal.open(config);
+        check(config.researchIteration == 4, "torn tail ignored");
+        advance(config, 5);
+        journal.record(config);
+    }
+    {
+        StateJournal journal(snapshot, options);
+        ProgramConfig config;
+        journal.open(config);
+        check(config.researchIteration == 5, "records after a truncated tail replay");
+    }
+    // History before the snapshot's offset is not read on open.
+    {
+        int fd = ::open((snapshot + ".journal").c_str(), O_WRONLY);
+        check(::pwrite(fd, "x", 1, 0) == 1, "corrupt journal history");
+        ::close(fd);
+        StateJournal journal(snapshot, options);
+        ProgramConfig config;
+        journal.open(config);
+        struct stat info;
+        check(config.researchIteration == 5 && ::stat((snapshot + ".journal").c_str(), &info) == 0 && info.st_size > 0,
+              "open replays only the tail past the snapshot");
+    }
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void benchStateJournal() {
+    std::cout << "--- Per-iteration persistence ---" << std::endl;
+    benchGroup = "persistence";
+    std::string dir = makeTempDir();
+    ProgramConfig config;
+    config.lastResearchSummary = makeSummaryText(4096, 7);
+    int iteration = 0;
+    runBench("ProgramConfig::save (atomic rewrite)", 5, 200, [&] {
+        config.researchIteration = ++iteration;
+        config.save(dir + "/config.json");
+    });
+    StateJournal journal(dir + "/journaled.json");
+    ProgramConfig journaled;
+    journal.open(journaled);
+    journaled.lastResearchSummary = config.lastResearchSummary;
+    runBench("StateJournal::record (delta append)", 5, 200, [&] {
+        journaled.researchIteration = ++iteration;
+        journaled.researchCompletenessScore = iteration * 0.5;
+        journal.record(journaled);
+    });
+    journal.close();
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testResearchTopic() {
+    ResearchTopic topic = ResearchTopic::fromLegacy("deepen_fix_deepen_deepen_general_knowledge");
+    check(topic.base() == "general_knowledge" && topic.count(TopicOp::DEEPEN) == 3 && topic.count(TopicOp::FIX) == 1, "legacy topic parsed");
+    check(topic.legacy() == "deepen_fix_deepen_deepen_general_knowledge", "legacy form round trips");
+    check(topic.display() == "general_knowledge (deepen x3, fix x1)", "display form");
+    check(&topic.base() == &ResearchTopic("general_knowledge").base(), "base topics are interned");
+    check(ResearchTopic::fromLegacy("fix_").base() == "fix_" && ResearchTopic::fromLegacy("refine_x").legacy() == "refine_x", "bare prefixes are not stripped");
+
+    // Alternating steps never merge into runs; the lineage must stay bounded.
+    ResearchTopic longest;
+    for (int i = 0; i < 10000; ++i) longest.push(i % 3 == 2 ? TopicOp::FIX : TopicOp::DEEPEN);
+    check(longest.depth() == 10000 && longest.count(TopicOp::FIX) == 3333, "folded steps still counted");
+    auto prefixes = [](const ResearchTopic& lineage) {
+        return static_cast<size_t>(std::count(lineage.legacy().begin(), lineage.legacy().end(), '_') -
+                                   std::count(lineage.base().begin(), lineage.base().end(), '_'));
+    };
+    check(prefixes(longest) == ResearchTopic::kMaxLegacyPrefixes && longest.legacy().compare(0, 11, "deepen_fix_") == 0,
+          "legacy form keeps the newest steps");
+    ResearchTopic alternating;
+    for (int i = 0; i < 40; ++i) alternating.push(i % 2 ? TopicOp::FIX : TopicOp::DEEPEN);
+    check(prefixes(alternating) == 40, "every step within the legacy window is rendered");
+    std::string migrated;
+    for (int i = 0; i < 30; ++i) migrated += i % 2 ? "fix_" : "deepen_";
+    migrated += "general_knowledge";
+    check(ResearchTopic::fromLegacy(migrated).legacy() == migrated, "long alternating legacy topic migrates intact");
+
+    ProgramConfig config;
+    config.researchTopic = longest;
+    std::string json;
+    config.toJson(json);
+    check(json.size() < 4096, "serialized lineage is bounded (" + std::to_string(json.size()) + " bytes)");
+    JsonDocument doc;
+    ProgramConfig reloaded;
+    check(doc.parse(json), "config with lineage parses");
+    reloaded.fromJson(doc.root());
+    check(reloaded.researchTopic == longest && reloaded.researchTopic.display() == longest.display(), "lineage round trips through the config");
+
+    // Configs written before the lineage existed only carry the prefixed string.
+    check(doc.parse("{\"researchTopic\": \"fix_deepen_quantum\"}"), "legacy config parses");
+    reloaded.fromJson(doc.root());
+    check(reloaded.researchTopic.base() == "quantum" && reloaded.researchTopic.depth() == 2, "legacy config topic migrated");
+    check(doc.parse("{\"topicLineage\": {\"base\": \"x\", \"ops\": [[\"sideways\", 1]]}}"), "bad lineage parses as JSON");
+    check(!reloaded.researchTopic.read(doc.root()["topicLineage"]) && reloaded.researchTopic.base() == "quantum", "invalid lineage rejected");
+}
+
+void testPacer() {
+    Pacer virtualPacer(PacingMode::VIRTUAL);
+    Pacer scaledPacer;
+    check(Pacer::parse("1000x", scaledPacer) && scaledPacer.mode() == PacingMode::SCALED, "parse scaled pacing");
+    check(!Pacer::parse("fast", scaledPacer) && !Pacer::parse("0x", scaledPacer), "reject bad pacing");
+
+    auto started = SteadyClock::now();
+    for (Pacer* pacer : {&virtualPacer, &scaledPacer}) {
+        pacer->pause(std::chrono::seconds(2));
+        pacer->pause(std::chrono::milliseconds(500));
+    }
+    check(SteadyClock::now() - started < std::chrono::milliseconds(100), "virtual and scaled pacing skip the wait");
+    check(virtualPacer.elapsed() == std::chrono::milliseconds(2500) && scaledPacer.elapsed() == virtualPacer.elapsed(),
+          "nominal durations identical across modes");
+
+    Pacer deferred(PacingMode::REAL_TIME);
+    deferred.setDeferred(true);
+    started = SteadyClock::now();
+    deferred.pause(std::chrono::seconds(3));
+    deferred.pause(std::chrono::seconds(2));
+    check(SteadyClock::now() - started < std::chrono::milliseconds(100), "deferred pacing does not sleep");
+    check(deferred.takeDeferred() == std::chrono::seconds(5) && deferred.takeDeferred().count() == 0, "deferred sleep handed to the caller once");
+}
+
+void testWorkStealingPool() {
+    WorkStealingPool pool(4);
+    std::vector<std::atomic<int>> runs(1000);
+    std::atomic<int> running{0};
+    std::atomic<int> peak{0};
+    pool.parallelFor(runs.size(), [&](size_t i) {
+        int now = ++running;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+        runs[i]++;
+        --running;
+    });
+    check(std::all_of(runs.begin(), runs.end(), [](const std::atomic<int>& count) { return count.load() == 1; }), "parallelFor runs every task once");
+    check(peak.load() <= 4, "pool bounds concurrent tasks");
+
+    // Worker 0 is dealt both slow tasks; an idle worker steals the second.
+    auto started = std::chrono::steady_clock::now();
+    pool.parallelFor(8, [](size_t i) {
+        if (i % 4 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    });
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    check(pool.steals() >= 1 && elapsed < std::chrono::milliseconds(190), "idle workers steal queued tasks");
+}
+
+void testFanOut() {
+    std::string dir = makeTempDir();
+    std::string researcher = dir + "/researcher.sh";
+    {
+        // Later subtopics answer first; subtopic 3 reports an error.
+        std::ofstream script(researcher);
+        script << "#!/bin/sh\nk=${1##*/}; k=${k%%-of-*}\nsleep 0.0$((5 - k))\n"
+               << "if [ $k = 3 ]; then error=true; else error=false; fi\n"
+               << "echo '{\"research_summary\": \"part '$k'\", \"research_completeness_score\": '$((k * 10))', \"error_found\": '$error', \"error_message\": \"shard failed\"}'\n";
+    }
+    ::chmod(researcher.c_str(), 0755);
+    OrchestratorOptions options;
+    options.researcherPath = researcher;
+    options.pacer = Pacer(PacingMode::VIRTUAL);
+    options.fanout = 4;
+    LoggerOptions quiet;
+    quiet.consoleLevel = LogLevel::ERROR;
+    Logger logger(quiet);
+    MetricsRegistry registry;
+    OrchestratorMetrics metrics(registry);
+    WorkStealingPool pool(4);
+
+    {
+        // Scoped so the session closes its stores before the directory goes.
+        ResearchSession session("fanout", dir, options, logger, metrics, 1);
+        session.openState();
+        session.openKnowledge();
+        session.useFanOut(&pool);
+        session.config().currentPhase = ProgramPhase::RESEARCH_CYCLE;
+        session.config().researchIteration = 1;
+        session.step();
+        const ProgramConfig& config = session.config();
+        check(config.lastResearchSummary == "[1/4] part 1 [2/4] part 2 [3/4] part 3 [4/4] part 4", "shard summaries merge in subtopic order");
+        check(config.researchCompletenessScore == 25.0, "combined score is the mean of the shard scores");
+        check(config.currentPhase == ProgramPhase::DEBUGGING && config.lastErrorMessage == "Subtopic 3/4: shard failed", "a shard reporting error_found sends the cycle to DEBUGGING");
+        std::vector<KnowledgeHit> hits;
+        check(session.knowledge().size() == 4 && session.knowledge().search("part", 4, hits) == 4, "each shard summary becomes a passage");
+    }
+    std::system(("rm -rf " + dir).c_str());
+}
+
+// Sessions in separate directories, driven concurrently against a shell
+// researcher that logs its start and end so overlap can be measured.
+void testResearchDaemon() {
+    std::string dir = makeTempDir();
+    std::string trace = dir + "/trace.log";
+    std::string researcher = dir + "/researcher.sh";
+    {
+        std::ofstream script(researcher);
+        script << "#!/bin/sh\necho + >> '" << trace << "'\nsleep 0.05\necho - >> '" << trace << "'\n"
+               << "echo '{\"research_summary\": \"findings for '$1'\", \"research_completeness_score\": 100, \"error_found\": false}'\n";
+    }
+    ::chmod(researcher.c_str(), 0755);
+    std::string root = dir + "/sessions";
+    ::mkdir(root.c_str(), 0755);
+    for (const char* name : {"alpha", "beta", "gamma", "delta", "epsilon", "stalled"}) ::mkdir((root + "/" + name).c_str(), 0755);
+    ProgramConfig stalled;
+    stalled.currentPhase = ProgramPhase::STALLED_UNRECOVERABLE;
+    stalled.save(root + "/stalled/config.json");
+    // A session whose journal cannot be opened (a directory in its place)
+    // must not run, and must not overwrite its snapshot.
+    ::mkdir((root + "/broken").c_str(), 0755);
+    ::mkdir((root + "/broken/config.json.journal").c_str(), 0755);
+    ProgramConfig broken;
+    broken.researchIteration = 7;
+    broken.save(root + "/broken/config.json");
+
+    OrchestratorOptions options;
+    options.researcherPath = researcher;
+    options.pacer = Pacer(PacingMode::VIRTUAL);
+    options.daemonWorkers = 3;
+    options.maxResearchers = 2;
+    LoggerOptions quiet;
+    quiet.consoleLevel = LogLevel::ERROR;
+    Logger logger(quiet);
+    MetricsRegistry registry;
+    OrchestratorMetrics metrics(registry);
+    int stalledCount = -1;
+    {
+        ResearchDaemon daemon(options, logger, registry, metrics, nullptr);
+        check(daemon.addSessions(root, 11) && daemon.sessionCount() == 7, "daemon picks up every session directory");
+        stalledCount = daemon.run();
+        check(daemon.session(2).name() == "broken" && daemon.session(2).config().currentPhase == ProgramPhase::STALLED_UNRECOVERABLE,
+              "a session whose journal cannot be opened is marked unrecoverable");
+    }
+    check(stalledCount == 2, "only the stalled and unopenable sessions are reported unrecoverable");
+    ProgramConfig brokenSaved;
+    check(brokenSaved.load(root + "/broken/config.json") && brokenSaved.researchIteration == 7 &&
+              brokenSaved.currentPhase == ProgramPhase::INITIAL_SETUP,
+          "unopenable session's snapshot is left untouched");
+    for (const char* name : {"alpha", "beta", "gamma", "delta", "epsilon"}) {
+        ProgramConfig saved;
+        KnowledgeBase knowledge(KnowledgeBaseOptions{root + "/" + name + "/.knowledge"});
+        check(saved.load(root + "/" + name + "/config.json") && saved.currentPhase == ProgramPhase::QUESTION_ANSWERING &&
+                  knowledge.open() && knowledge.size() == 1,
+              std::string("session '") + name + "' completed with its own state");
+    }
+
+    std::string lines;
+    readFile(trace, lines);
+    int running = 0;
+    int peak = 0;
+    int calls = 0;
+    for (char c : lines) {
+        if (c == '+') peak = std::max(peak, ++running), ++calls;
+        if (c == '-') --running;
+    }
+    check(calls == 5 && peak <= 2, "researcher concurrency limit respected (peak " + std::to_string(peak) + ")");
+    check(peak == 2, "researchers of different sessions overlap");
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testPhaseSimulator() {
+    PhaseSimulator simulator(4);
+    SimulationOptions options;
+    options.trajectories = 20000;
+    options.seed = 7;
+
+    // No errors and no LLM detour: setup, ten research cycles to reach 100,
+    // final analysis.
+    SimulationParameters straight;
+    straight.research.errorRate = 0.0;
+    straight.rules.llmIntegrationChance = 0.0;
+    SimulationReport report = simulator.run(straight, options);
+    check(report.completed == options.trajectories && report.iterationsPercentile(0.0) == 12 && report.iterationsPercentile(1.0) == 12,
+          "error-free trajectories all complete in 12 iterations");
+
+    // Validation always passes by the third attempt, before the fifth stalls.
+    SimulationParameters defaults;
+    report = simulator.run(defaults, options);
+    check(report.trajectories == options.trajectories && report.completed == options.trajectories && report.stalled == 0,
+          "default thresholds never stall");
+    check(report.iterationsPercentile(0.5) > 12 && report.meanIterations() > 12.0, "errors and LLM integration lengthen runs");
+
+    SimulationParameters hopeless;
+    hopeless.research.errorRate = 1.0;
+    hopeless.rules.validationPassRate = 0.0;
+    hopeless.rules.forcedPassAfter = 10;
+    report = simulator.run(hopeless, options);
+    check(report.stalled == options.trajectories && report.stallProbability() == 1.0, "failing validation past stall-after stalls every run");
+
+    SimulationParameters sometimes;
+    sometimes.rules.validationPassRate = 0.5;
+    sometimes.rules.forcedPassAfter = 10;
+    SimulationReport wide = simulator.run(sometimes, options);
+    PhaseSimulator single(1);
+    SimulationReport narrow = single.run(sometimes, options);
+    check(wide.stalled > 0 && wide.completed > 0 && wide.stalled + wide.completed == options.trajectories, "stall probability between 0 and 1");
+    check(wide.stalled == narrow.stalled && wide.completedAt == narrow.completedAt, "results do not depend on the thread count");
+
+    std::vector<SweepAxis> axes(2);
+    check(axes[0].parse("validation-pass-rate=0.5:0.9:0.1") && axes[0].values.size() == 5, "sweep range includes its end");
+    check(axes[1].parse("stall-after=4") && axes[1].values.size() == 1, "single-value sweep");
+    SweepAxis bad;
+    check(!bad.parse("no-such-parameter=1") && !bad.parse("error-rate=0.5:0.1:0.1") && !bad.parse("error-rate=x"), "invalid sweeps are rejected");
+    std::vector<SimulationParameters> points;
+    std::vector<std::string> labels;
+    expandSweep(axes, SimulationParameters(), points, labels);
+    check(points.size() == 5 && points[4].rules.validationPassRate > 0.89 && points[4].rules.stallAfter == 4 &&
+              labels[0] == "validation-pass-rate=0.5 stall-after=4",
+          "sweeps expand to a labelled grid");
+}
+
+void writeText(const std::string& path, const std::string& text) {
+    std::ofstream out(path, std::ios::binary);
+    out << text;
+}
+
+void testDebugScanner() {
+    std::mt19937 gen(11);
+    std::string haystack;
+    for (int i = 0; i < 5000; ++i) haystack.push_back("abcab\n"[gen() % 6]);
+    bool agrees = true;
+    for (size_t length : {1, 2, 3, 5, 9, 17, 33}) {
+        for (int trial = 0; trial < 40; ++trial) {
+            std::string needle = haystack.substr(gen() % (haystack.size() - length), length);
+            if (trial % 4 == 0) needle.back() = 'z';
+            size_t start = gen() % 100;
+            const char* found = findSubstring(haystack.data() + start, haystack.size() - start, needle);
+            size_t expected = haystack.find(needle, start);
+            agrees &= expected == std::string::npos ? found == nullptr : found == haystack.data() + expected;
+        }
+    }
+    check(agrees, "findSubstring agrees with std::string::find");
+
+    std::string dir = makeTempDir();
+    std::system(("mkdir -p " + dir + "/src/core " + dir + "/logs/deep " + dir + "/.hidden").c_str());
+    std::string signature = "can't parse \"value\" for 'key'";
+    writeText(dir + "/src/core/parse.rs", "fn parse() {\n    // ok\n    panic!(\"can't parse \\\"value\\\" for 'key'\");\n    let x = 1; // can't parse \"value\" for 'key' twice: can't parse \"value\" for 'key'\n}\n");
+    writeText(dir + "/src/clean.rs", "fn main() {}\n");
+    std::string log;
+    for (int i = 1; i <= 15; ++i) log += "line " + std::to_string(i) + "\n";
+    writeText(dir + "/logs/deep/app.log", log);
+    writeText(dir + "/logs/short.log", "only line");
+    writeText(dir + "/.hidden/skip.log", "hidden\n");
+    writeText(dir + "/notes.txt", signature + "\n");
+
+    WorkStealingPool pool(3);
+    DebugScanOptions options;
+    options.root = dir;
+    DebugScanner scanner(options, pool);
+    DebugScanResult result;
+    scanner.scan(signature, result);
+    check(result.filesSeen == 4 && result.filesScanned == 4, "scan walks logs and sources only, skipping dot-directories");
+    check(result.matches.size() == 1 && result.matches[0].file == "src/core/parse.rs" && result.matches[0].line == 4 &&
+              result.matches[0].context == "    let x = 1; // can't parse \"value\" for 'key' twice: can't parse \"value\" for 'key'",
+          "signature with quotes matched once per line with its line number");
+    check(result.tails.size() == 2 && result.tails[0].file == "logs/deep/app.log" && result.tails[0].lines.size() == 10 &&
+              result.tails[0].lines.front() == "line 6" && result.tails[0].lines.back() == "line 15" &&
+              result.tails[1].lines == std::vector<std::string>{"only line"},
+          "logs are tailed from EOF");
+
+    scanner.scan(signature, result);
+    check(result.filesScanned == 0 && result.matches.size() == 1 && result.tails.size() == 2, "unchanged files come from the index");
+    writeText(dir + "/src/clean.rs", "fn main() {}\n// " + signature + "\n");
+    std::system(("rm " + dir + "/logs/short.log").c_str());
+    scanner.scan(signature, result);
+    check(result.filesScanned == 1 && result.matches.size() == 2 && result.matches[0].file == "src/clean.rs" && result.matches[0].line == 2 &&
+              result.tails.size() == 1 && scanner.indexedFiles() == 3,
+          "changed and deleted files are picked up");
+    scanner.scan("fn main", result);
+    check(result.filesScanned == 2 && result.matches.size() == 1, "a new signature searches the sources again");
+
+    ProgramConfig config;
+    config.debugMatches = {{"src/a.rs", 3, "say \"hi\""}};
+    std::string json;
+    config.toJson(json);
+    JsonDocument doc;
+    ProgramConfig loaded;
+    check(doc.parse(json) && (loaded.fromJson(doc.root()), loaded.debugMatches == config.debugMatches), "debug matches round-trip through the config");
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testValidationRunner() {
+    std::string dir = makeTempDir();
+    std::system(("mkdir -p " + dir + "/src").c_str());
+    writeText(dir + "/src/a.txt", "alpha\n");
+    writeText(dir + "/src/b.txt", "ok\n");
+    writeText(dir + "/validation.json",
+              "{\"timeout\": 10, \"units\": [{\"name\": \"a\", \"command\": [\"test\", \"-s\", \"src/a.txt\"], \"inputs\": [\"src/a.txt\"]},"
+              " {\"name\": \"b\", \"command\": \"grep -q ^ok src/b.txt\", \"inputs\": [\"src\"]}]}");
+    WorkStealingPool pool(2);
+    std::string error;
+    ValidationRunner runner(dir + "/validation.json", pool);
+    check(runner.load(error) && runner.manifest().size() == 2, "validation manifest loads");
+    ValidationReport report;
+    runner.run(report);
+    check(report.passed && report.ran == 2 && report.shards[0].status == ShardStatus::PASSED && report.shards[1].status == ShardStatus::PASSED,
+          "units run in the manifest's directory");
+    runner.run(report);
+    check(report.passed && report.ran == 0 && report.cached == 2, "unchanged units reuse their pass");
+
+    writeText(dir + "/src/b.txt", "broken\n");
+    runner.run(report);
+    check(!report.passed && report.firstFailure == 1 && report.shards[0].status == ShardStatus::CACHED && report.shards[1].status == ShardStatus::FAILED &&
+              report.shards[1].detail.find("exited with status 1") != std::string::npos,
+          "a changed input reruns its unit and the failure is reported");
+    writeText(dir + "/src/b.txt", "ok again\n");
+    ValidationRunner reloaded(dir + "/validation.json", pool);
+    check(reloaded.load(error), "validation manifest reloads");
+    reloaded.run(report);
+    check(report.passed && report.shards[0].status == ShardStatus::CACHED && report.shards[1].status == ShardStatus::PASSED, "passes persist across runners");
+
+    // The first failure cancels a shard that is still running.
+    writeText(dir + "/stop.json", "{\"units\": [{\"name\": \"fails\", \"command\": \"sleep 0.2; exit 3\"}, {\"name\": \"slow\", \"command\": [\"sleep\", \"5\"]}]}");
+    ValidationRunner stopping(dir + "/stop.json", pool);
+    stopping.load(error);
+    auto started = std::chrono::steady_clock::now();
+    stopping.run(report);
+    auto elapsed = std::chrono::steady_clock::now() - started;
+    check(!report.passed && report.firstFailure == 0 && report.shards[1].status == ShardStatus::CANCELLED &&
+              elapsed < std::chrono::seconds(2),
+          "the first failure cancels running shards");
+
+    writeText(dir + "/hang.json", "{\"units\": [{\"name\": \"hang\", \"command\": [\"sleep\", \"5\"], \"timeout\": 0.2}]}");
+    ValidationRunner hanging(dir + "/hang.json", pool);
+    hanging.load(error);
+    hanging.run(report);
+    check(!report.passed && report.shards[0].status == ShardStatus::TIMED_OUT && report.shards[0].elapsed < std::chrono::seconds(2), "per-shard timeouts");
+    writeText(dir + "/bad.json", "{\"units\": [{\"name\": \"nothing\"}]}");
+    ValidationRunner bad(dir + "/bad.json", pool);
+    check(!bad.load(error) && !error.empty(), "units without a command are rejected");
+
+    // The session decides VALIDATION_TESTS from the real outcome.
+    OrchestratorOptions options;
+    options.pacer = Pacer(PacingMode::VIRTUAL);
+    LoggerOptions quiet;
+    quiet.consoleLevel = LogLevel::ERROR;
+    Logger logger(quiet);
+    MetricsRegistry registry;
+    OrchestratorMetrics metrics(registry);
+    ResearchSession session("validation", dir, options, logger, metrics, 1);
+    session.openState();
+    session.useValidationRunner(&reloaded);
+    writeText(dir + "/src/b.txt", "broken again\n");
+    session.config().currentPhase = ProgramPhase::VALIDATION_TESTS;
+    session.config().debugAttempts = 4;
+    session.step();
+    check(session.config().currentPhase == ProgramPhase::DEBUGGING && session.config().validationResults.size() == 2 &&
+              session.config().validationResults[1].status == "failed",
+          "a failing unit sends the session back to DEBUGGING, past the forced pass");
+    writeText(dir + "/src/b.txt", "ok\n");
+    session.config().currentPhase = ProgramPhase::VALIDATION_TESTS;
+    session.step();
+    check(session.config().currentPhase == ProgramPhase::RESEARCH_CYCLE && session.config().debugAttempts == 0 &&
+              session.config().validationResults[1].status == "passed",
+          "passing units resume research");
+    // step() set this thread's log context; later logger checks expect none.
+    Logger::setContext(-1, nullptr);
+    Logger::setSession(nullptr);
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testResultCache() {
+    std::string dir = makeTempDir();
+    ResultCacheOptions options;
+    options.directory = dir + "/cache";
+    options.maxMemoryEntries = 2;
+    std::string output;
+    {
+        ResultCache cache(1, options);
+        check(!cache.lookup("topic", 1, output), "cold cache misses");
+        cache.store("topic", 1, "{\"research_summary\": \"one\"}");
+        cache.store("topic", 2, "{\"research_summary\": \"two\"}");
+        cache.store("topic", 3, "{\"research_summary\": \"three\"}");
+        check(cache.lookup("topic", 3, output) && output == "{\"research_summary\": \"three\"}", "memory hit");
+        check(cache.lookup("topic", 1, output) && cache.stats().diskHits == 1, "LRU-evicted entry served from disk");
+        check(cache.stats().memoryHits == 1 && cache.stats().misses == 1 && cache.stats().memoryEvictions >= 1 &&
+                  cache.stats().diskEvictions == 0,
+              "counters track hits, misses and evictions");
+    }
+    {
+        ResultCache cache(1, options);
+        check(cache.lookup("topic", 2, output) && output == "{\"research_summary\": \"two\"}", "entries survive restart");
+        ResultCache rebuilt(2, options);
+        check(!rebuilt.lookup("topic", 2, output), "new researcher binary does not reuse old results");
+    }
+    {
+        options.maxDiskBytes = 1;
+        ResultCache cache(1, options);
+        check(cache.diskUsage() <= 1 && !cache.lookup("topic", 2, output) && cache.stats().diskEvictions >= 1, "disk budget enforced");
+    }
+    {
+        // A corrupt entry misses; storing over it must not count its file twice.
+        options.directory = dir + "/overwrite";
+        options.maxDiskBytes = 256u * 1024u * 1024u;
+        std::string path;
+        {
+            ResultCache cache(1, options);
+            cache.store("topic", 1, "{\"research_summary\": \"one\"}");
+            DIR* entries = ::opendir(options.directory.c_str());
+            while (dirent* item = ::readdir(entries)) {
+                if (item->d_name[0] != '.') path = options.directory + "/" + item->d_name;
+            }
+            ::closedir(entries);
+        }
+        writeText(path, "{\"torn");
+        ResultCache cache(1, options);
+        check(!cache.lookup("topic", 1, output), "corrupt disk entry misses");
+        cache.store("topic", 1, "{\"research_summary\": \"one\"}");
+        struct stat info;
+        check(::stat(path.c_str(), &info) == 0 && cache.diskUsage() == static_cast<size_t>(info.st_size), "overwritten entry counted once");
+        options.maxDiskBytes = static_cast<size_t>(info.st_size);
+        ResultCache bounded(1, options);
+        check(bounded.lookup("topic", 1, output) && bounded.stats().diskEvictions == 0, "overwritten entry survives the disk budget");
+    }
+    {
+        // A researcher that prints a result and then exits nonzero is not cached.
+        std::string researcher = dir + "/crashing.sh";
+        writeText(researcher, "#!/bin/sh\necho run >> '" + dir + "/calls'\n"
+                              "echo '{\"research_summary\": \"partial\", \"research_completeness_score\": 10, \"error_found\": false}'\nexit 3\n");
+        ::chmod(researcher.c_str(), 0755);
+        OrchestratorOptions sessionOptions;
+        sessionOptions.researcherPath = researcher;
+        sessionOptions.pacer = Pacer(PacingMode::VIRTUAL);
+        options.directory = dir + "/crashing";
+        ResultCache cache(hashExecutable(researcher), options);
+        LoggerOptions quiet;
+        quiet.consoleLevel = LogLevel::ERROR;
+        Logger logger(quiet);
+        MetricsRegistry registry;
+        OrchestratorMetrics metrics(registry);
+        ResearchSession session("crashing", dir, sessionOptions, logger, metrics, 1);
+        session.openState();
+        session.useResultCache(&cache);
+        for (int run = 0; run < 2; ++run) {
+            session.config().currentPhase = ProgramPhase::RESEARCH_CYCLE;
+            session.config().researchIteration = 0;
+            session.step();
+        }
+        std::string calls;
+        readFile(dir + "/calls", calls);
+        check(session.config().lastResearchSummary == "partial" && cache.stats().stores == 0 && cache.stats().misses == 2 && calls == "run\nrun\n",
+              "results of a researcher that exited nonzero are used but not cached");
+        Logger::setContext(-1, nullptr);
+        Logger::setSession(nullptr);
+    }
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testKnowledgeBase() {
+    std::string dir = makeTempDir();
+    KnowledgeBaseOptions options;
+    options.directory = dir + "/kb";
+    options.flushEveryPassages = 4;
+    std::vector<KnowledgeHit> hits;
+    {
+        KnowledgeBase knowledge(options);
+        check(knowledge.open() && knowledge.size() == 0, "empty knowledge base opens");
+        knowledge.add(1, "solar", "Photovoltaic efficiency drops at high temperature.");
+        knowledge.add(2, "solar", "Battery storage smooths solar output at night.");
+        knowledge.add(3, "wind", "Offshore wind turbines face corrosion.");
+        check(knowledge.search("How does storage help at NIGHT?", 2, hits) >= 1 && hits[0].iteration == 2, "delta index ranks the matching passage first");
+        check(hits.size() == 1, "passages without query terms are not returned");
+        knowledge.add(4, "wind", "Corrosion-resistant coatings extend turbine life.");
+        check(knowledge.pendingPassages() == 0, "reaching the flush threshold writes a segment");
+        knowledge.add(5, "solar", "Night storage: batteries, storage, storage.");
+        knowledge.add(5, "solar", "Night storage: batteries, storage, storage.");
+        check(knowledge.search("storage", 5, hits) == 2 && hits[0].iteration == 5 && hits[1].iteration == 2, "segment and delta are merged and duplicates collapse");
+    }
+    {
+        KnowledgeBase knowledge(options);
+        check(knowledge.open() && knowledge.size() == 6 && knowledge.pendingPassages() == 2, "reopened store maps its segment and indexes the log tail");
+        check(knowledge.search("turbine corrosion", 3, hits) == 2 && hits[0].topic == "wind", "mapped segment answers queries");
+        check(knowledge.flush() && knowledge.pendingPassages() == 0, "explicit flush writes the tail into the segment");
+    }
+    {
+        // A torn log tail is discarded; a segment that no longer matches the log is rebuilt.
+        std::string log = dir + "/kb/passages.log";
+        std::string contents;
+        readFile(log, contents);
+        writeFileAtomically(log, contents.substr(0, contents.size() - 5));
+        KnowledgeBase knowledge(options);
+        check(knowledge.open() && knowledge.size() == 5, "torn passage dropped and index rebuilt");
+        check(knowledge.search("coatings", 1, hits) == 1 && hits[0].iteration == 4, "rebuilt index answers queries");
+    }
+    std::system(("rm -rf " + dir).c_str());
+}
+
+int connectUnix(const std::string& path) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::snprintf(address.sun_path, sizeof(address.sun_path), "%s", path.c_str());
+    if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Reads until `lines` newline-terminated lines have arrived or the peer closes.
+std::vector<std::string> readLines(int fd, size_t lines, std::string& pending) {
+    std::vector<std::string> out;
+    char buffer[65536];
+    for (;;) {
+        size_t newline;
+        while (out.size() < lines && (newline = pending.find('\n')) != std::string::npos) {
+            out.push_back(pending.substr(0, newline));
+            pending.erase(0, newline + 1);
+        }
+        if (out.size() >= lines) return out;
+        ssize_t got = ::read(fd, buffer, sizeof(buffer));
+        if (got <= 0) return out;
+        pending.append(buffer, static_cast<size_t>(got));
+    }
+}
+
+void testQuestionServer() {
+    std::string dir = makeTempDir();
+    KnowledgeBase knowledge(KnowledgeBaseOptions{dir + "/kb"});
+    knowledge.open();
+    knowledge.add(1, "solar", "Photovoltaic efficiency drops at high temperature.");
+    knowledge.add(2, "solar", "Battery storage smooths solar output at night.");
+    knowledge.add(3, "wind", "Offshore wind turbines face corrosion.");
+    ProgramConfig config;
+    config.researchTopic = ResearchTopic("solar");
+    config.lastResearchSummary = "no passage matched";
+    config.researchCompletenessScore = 100;
+    MetricsRegistry registry;
+    OrchestratorMetrics metrics(registry);
+    QuestionServerOptions options;
+    options.workers = 3;
+    options.maxPipelined = 4;
+    options.maxLineBytes = 1024;
+    QuestionServer server(knowledge, config, options, metrics);
+
+    std::string socketPath = dir + "/qa.sock";
+    check(server.listen(socketPath), "question server listens");
+    std::thread loop([&] { server.serve(); });
+
+    // Several clients pipeline far past maxPipelined; answers come back in order.
+    const int questions = 200;
+    std::vector<std::thread> clients;
+    std::vector<int> ordered(4, 0);
+    for (size_t c = 0; c < ordered.size(); ++c) {
+        clients.emplace_back([&, c] {
+            int fd = connectUnix(socketPath);
+            if (fd < 0) return;
+            std::string request;
+            for (int i = 0; i < questions; ++i) request += i % 2 ? "storage at night\n" : "turbine corrosion?\r\n";
+            ssize_t ignored = ::write(fd, request.data(), request.size());
+            (void)ignored;
+            ::shutdown(fd, SHUT_WR);
+            std::string pending;
+            std::vector<std::string> lines = readLines(fd, questions + 1, pending);
+            ::close(fd);
+            JsonDocument answer;
+            bool inOrder = lines.size() == questions;
+            for (int i = 0; inOrder && i < questions; ++i) {
+                inOrder = answer.parse(lines[i]) && answer.root()["id"].asInt(-1) == i &&
+                          answer.root()["passages"].at(0)["iteration"].asInt(0) == (i % 2 ? 2 : 3);
+            }
+            ordered[c] = inOrder;
+        });
+    }
+    for (std::thread& client : clients) client.join();
+    check(std::count(ordered.begin(), ordered.end(), 1) == 4, "pipelined answers arrive complete and in order");
+
+    int fd = connectUnix(socketPath);
+    std::string pending;
+    std::string question = "storage\n" + std::string(2000, 'x');
+    ssize_t ignored = ::write(fd, question.data(), question.size());
+    (void)ignored;
+    std::vector<std::string> lines = readLines(fd, 3, pending);
+    JsonDocument answer;
+    check(lines.size() == 2 && answer.parse(lines[0]) && answer.root()["answer"].asString() == "Battery storage smooths solar output at night." &&
+              answer.root()["topic"].asString() == "solar" && answer.parse(lines[1]) && answer.root()["id"].asInt(-1) == 1 &&
+              answer.root()["error"].isString(),
+          "oversized question is rejected and the connection closed");
+    ::close(fd);
+
+    server.requestStop();
+    loop.join();
+    check(metrics.questions.get() == 4 * questions + 2, "answered questions are counted");
+
+    std::string batchPath = dir + "/questions.txt";
+    std::string answersPath = dir + "/answers.jsonl";
+    writeFileAtomically(batchPath, "why corrosion\n\nunrelated words\nnight storage");
+    int input = ::open(batchPath.c_str(), O_RDONLY);
+    int output = ::open(answersPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    long long answered = server.answerBatch(input, output);
+    ::close(input);
+    ::close(output);
+    std::string batch;
+    readFile(answersPath, batch);
+    std::istringstream batchLines(batch);
+    std::string line;
+    std::vector<std::string> answers;
+    while (std::getline(batchLines, line)) answers.push_back(line);
+    check(answered == 3 && answers.size() == 3 && answer.parse(answers[1]) && answer.root()["id"].asInt(-1) == 1 &&
+              answer.root()["answer"].asString() == "no passage matched" && answer.parse(answers[2]) &&
+              answer.root()["passages"].at(0)["iteration"].asInt(0) == 2,
+          "batch mode answers every question in order");
+    knowledge.close();
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void benchKnowledgeBase() {
+    std::cout << "--- Knowledge base retrieval ---" << std::endl;
+    benchGroup = "knowledge base";
+    std::string dir = makeTempDir();
+    KnowledgeBaseOptions options;
+    options.directory = dir + "/kb";
+    KnowledgeBase knowledge(options);
+    knowledge.open();
+    const int passages = 50000;
+    std::mt19937 gen(11);
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < 5000; ++i) vocabulary.push_back("term" + std::to_string(i));
+    std::uniform_int_distribution<size_t> pick(0, vocabulary.size() - 1);
+    std::string text;
+    auto started = std::chrono::steady_clock::now();
+    for (int i = 0; i < passages; ++i) {
+        text.clear();
+        for (int w = 0; w < 40; ++w) text += vocabulary[pick(gen)] + " ";
+        knowledge.add(i, "bench_topic", text);
+    }
+    double perPassageUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count() / passages;
+    std::cout << "  add (" << passages << " passages incl. flushes): mean " << perPassageUs << " us per passage" << std::endl;
+    std::vector<KnowledgeHit> hits;
+    int query = 0;
+    runBench("search top-3 over " + std::to_string(knowledge.size()) + " passages", 20, 500, [&] {
+        knowledge.search(vocabulary[(query * 7) % vocabulary.size()] + " " + vocabulary[(query * 13 + 5) % vocabulary.size()], 3, hits);
+        ++query;
+    });
+    knowledge.close();
+    auto reopenStarted = std::chrono::steady_clock::now();
+    KnowledgeBase reopened(options);
+    reopened.open();
+    std::cout << "  open (mapped segment): " << std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - reopenStarted).count() << " us" << std::endl;
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void benchQuestionServer() {
+    std::cout << "--- Question server ---" << std::endl;
+    benchGroup = "qa server";
+    std::string dir = makeTempDir();
+    KnowledgeBase knowledge(KnowledgeBaseOptions{dir + "/kb"});
+    knowledge.open();
+    std::mt19937 gen(13);
+    std::vector<std::string> vocabulary;
+    for (int i = 0; i < 2000; ++i) vocabulary.push_back("term" + std::to_string(i));
+    std::uniform_int_distribution<size_t> pick(0, vocabulary.size() - 1);
+    std::string text;
+    for (int i = 0; i < 10000; ++i) {
+        text.clear();
+        for (int w = 0; w < 40; ++w) text += vocabulary[pick(gen)] + " ";
+        knowledge.add(i, "bench_topic", text);
+    }
+    knowledge.flush();
+    ProgramConfig config;
+    MetricsRegistry registry;
+    OrchestratorMetrics metrics(registry);
+    QuestionServerOptions options;
+    options.workers = std::max(2u, std::thread::hardware_concurrency());
+    QuestionServer server(knowledge, config, options, metrics);
+    std::string socketPath = dir + "/qa.sock";
+    server.listen(socketPath);
+    std::thread loop([&] { server.serve(); });
+
+    // Each client keeps a window of questions in flight and records the time
+    // from sending a window to receiving each of its answers.
+    const int clients = 16;
+    const int rounds = 40;
+    const int window = 32;
+    std::vector<std::vector<double>> latencies(clients);
+    auto started = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            int fd = connectUnix(socketPath);
+            if (fd < 0) return;
+            std::string request;
+            std::string pending;
+            for (int round = 0; round < rounds; ++round) {
+                request.clear();
+                for (int i = 0; i < window; ++i) {
+                    request += vocabulary[static_cast<size_t>(c * 131 + round * 17 + i * 7) % vocabulary.size()] + " " +
+                               vocabulary[static_cast<size_t>(c * 31 + round * 5 + i * 3 + 1) % vocabulary.size()] + "\n";
+                }
+                auto sent = std::chrono::steady_clock::now();
+                ssize_t ignored = ::write(fd, request.data(), request.size());
+                (void)ignored;
+                size_t got = 0;
+                char buffer[65536];
+                while (got < static_cast<size_t>(window)) {
+                    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+                    if (n <= 0) break;
+                    auto now = std::chrono::steady_clock::now();
+                    size_t lines = static_cast<size_t>(std::count(buffer, buffer + n, '\n'));
+                    for (size_t i = 0; i < lines; ++i) latencies[c].push_back(std::chrono::duration<double, std::nano>(now - sent).count());
+                    got += lines;
+                }
+            }
+            ::close(fd);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    server.requestStop();
+    loop.join();
+
+    std::vector<double> samples;
+    for (const auto& client : latencies) samples.insert(samples.end(), client.begin(), client.end());
+    if (!samples.empty()) {
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&](double q) { return samples[static_cast<size_t>(q * static_cast<double>(samples.size() - 1) + 0.5)]; };
+        double total = 0.0;
+        for (double sample : samples) total += sample;
+        BenchResult result{benchGroup, std::to_string(clients) + " clients x " + std::to_string(window) + " pipelined, " + std::to_string(options.workers) + " workers",
+                           static_cast<int>(samples.size()), total / static_cast<double>(samples.size()), samples.front(), percentile(0.5),
+                           percentile(0.9), percentile(0.99), samples.back()};
+        benchResults.push_back(result);
+        std::cout << "  " << result.name << ": " << static_cast<double>(samples.size()) / seconds << " answers/s, median "
+                  << result.medianNs / 1000.0 << " us, p99 " << result.p99Ns / 1000.0 << " us" << std::endl;
+    }
+
+    std::string batchPath = dir + "/questions.txt";
+    std::string questions;
+    for (int i = 0; i < 20000; ++i) questions += vocabulary[static_cast<size_t>(i * 7) % vocabulary.size()] + " " + vocabulary[static_cast<size_t>(i * 13 + 5) % vocabulary.size()] + "\n";
+    writeFileAtomically(batchPath, questions);
+    runBench("batch of 20000 questions", 0, 3, [&] {
+        int input = ::open(batchPath.c_str(), O_RDONLY);
+        int output = ::open("/dev/null", O_WRONLY);
+        server.answerBatch(input, output);
+        ::close(input);
+        ::close(output);
+    });
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testLogger() {
+    std::string dir = makeTempDir();
+    LoggerOptions options;
+    options.consoleLevel = LogLevel::ERROR; // keep the test output clean; INFO reaches the JSON sink only
+    options.jsonPath = dir + "/log.jsonl";
+    options.capacity = 64; // small ring so producers have to wait for the writer
+    const int threads = 4;
+    const int perThread = 5000;
+    {
+        Logger logger(options);
+        std::vector<std::thread> producers;
+        for (int t = 0; t < threads; ++t) {
+            producers.emplace_back([&logger, t] {
+                Logger::setContext(t, "RESEARCH_CYCLE");
+                for (int i = 0; i < perThread; ++i) logger.info() << "thread " << t << " record " << i;
+            });
+        }
+        for (std::thread& producer : producers) producer.join();
+        logger.flush();
+        std::string contents;
+        readFile(options.jsonPath, contents);
+        check(static_cast<int>(std::count(contents.begin(), contents.end(), '\n')) == threads * perThread, "flush writes every record");
+        logger.debug() << "after flush";
+    }
+
+    std::string contents;
+    readFile(options.jsonPath, contents);
+    std::vector<int> next(threads, 0);
+    bool ordered = true;
+    JsonDocument doc;
+    size_t position = 0;
+    int records = 0;
+    while (position < contents.size()) {
+        size_t newline = contents.find('\n', position);
+        if (!doc.parse(std::string_view(contents).substr(position, newline - position))) break;
+        ++records;
+        int thread = doc.root()["iteration"].asInt(-1);
+        if (thread >= 0) {
+            std::string expected = "thread " + std::to_string(thread) + " record " + std::to_string(next[thread]++);
+            ordered = ordered && doc.root()["message"].asString() == expected && doc.root()["phase"].asString() == "RESEARCH_CYCLE";
+        }
+        position = newline + 1;
+    }
+    check(records == threads * perThread + 1, "destructor drains records logged after the last flush");
+    check(ordered, "records keep per-thread order and context");
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void benchLogger() {
+    std::cout << "--- Logging ---" << std::endl;
+    benchGroup = "logging";
+    std::ofstream sink("/dev/null");
+    int i = 0;
+    runBench("std::ostream << std::endl (1000 lines)", 3, 50, [&] {
+        for (int n = 0; n < 1000; ++n) sink << "[ORCHESTRATOR]: Progress update: Research completeness score is now " << ++i << "%." << std::endl;
+    });
+    LoggerOptions options;
+    options.consoleLevel = LogLevel::ERROR;
+    options.jsonPath = "/dev/null";
+    Logger logger(options);
+    runBench("Logger::info, JSON sink (1000 lines)", 3, 50, [&] {
+        for (int n = 0; n < 1000; ++n) logger.info() << "[ORCHESTRATOR]: Progress update: Research completeness score is now " << ++i << "%.";
+    });
+    logger.flush();
+    options.jsonPath.clear();
+    Logger quiet(options);
+    runBench("Logger::info, filtered out (1000 lines)", 3, 50, [&] {
+        for (int n = 0; n < 1000; ++n) quiet.info() << "[ORCHESTRATOR]: Progress update: Research completeness score is now " << ++i << "%.";
+    });
+}
+
+void testMetrics() {
+    bool bounded = true;
+    for (uint64_t value : {0ull, 1ull, 31ull, 32ull, 33ull, 1000ull, 123456789ull, 987654321012ull}) {
+        uint64_t upper = LatencyHistogram::bucketUpper(LatencyHistogram::bucketFor(value));
+        bounded = bounded && upper >= value && static_cast<double>(upper - value) <= value / 32.0 + 1.0;
+    }
+    check(bounded, "histogram buckets stay within 1/32 of the recorded value");
+
+    MetricsRegistry registry;
+    LatencyHistogram& latency = registry.histogram("test_latency_seconds", "Test latency", "operation=\"a\"");
+    Counter& events = registry.counter("test_events_total", "Test events");
+    registry.counter("test_unused_total", "Never incremented");
+    Gauge& level = registry.gauge("test_level", "Test gauge");
+    for (uint64_t i = 1; i <= 1000; ++i) latency.record(i * 1000); // 1us .. 1ms
+    events.increment(3);
+    level.set(42.5);
+    check(latency.count() == 1000 && latency.sumNanoseconds() == 500500000ull, "histogram count and sum");
+    uint64_t median = latency.quantile(0.5);
+    check(median >= 500000 && median <= 520000, "median within bucket resolution");
+    check(latency.quantile(0.99) >= 990000 && latency.quantile(1.0) >= 1000000, "tail quantiles");
+
+    std::string text;
+    registry.render(text);
+    check(text.find("# TYPE test_latency_seconds histogram\n") != std::string::npos, "histogram TYPE line");
+    check(text.find("test_latency_seconds_bucket{operation=\"a\",le=\"+Inf\"} 1000\n") != std::string::npos, "+Inf bucket holds every sample");
+    check(text.find("test_latency_seconds_bucket{operation=\"a\",le=\"0.0001\"} 9") != std::string::npos, "le bucket is cumulative");
+    check(text.find("test_latency_seconds_count{operation=\"a\"} 1000\n") != std::string::npos, "histogram count line");
+    check(text.find("test_events_total 3\n") != std::string::npos && text.find("test_level 42.5\n") != std::string::npos, "counter and gauge lines");
+    check(text.find("test_unused_total") == std::string::npos, "empty counters are omitted");
+}
+
+void benchMetrics() {
+    std::cout << "--- Metrics ---" << std::endl;
+    benchGroup = "metrics";
+    LatencyHistogram histogram;
+    Counter counter;
+    uint64_t value = 1;
+    runBench("LatencyHistogram::record (1000 samples)", 3, 200, [&] {
+        for (int i = 0; i < 1000; ++i) histogram.record((value = value * 6364136223846793005ull + 1442695040888963407ull) >> 40);
+    });
+    runBench("ScopedSpan + Counter::increment (1000 spans)", 3, 200, [&] {
+        for (int i = 0; i < 1000; ++i) {
+            ScopedSpan span(histogram);
+            counter.increment();
+        }
+    });
+}
+
+void benchDebugScanner() {
+    std::cout << "--- DEBUGGING scan ---" << std::endl;
+    benchGroup = "debug scan";
+    std::string dir = makeTempDir();
+    std::system(("mkdir -p " + dir + "/src " + dir + "/logs").c_str());
+    std::string signature = "stub researcher: simulated data inconsistency";
+    for (int i = 0; i < 200; ++i) {
+        std::string text = makeSummaryText(64 * 1024, static_cast<unsigned>(i));
+        if (i % 50 == 0) text += "\n// " + signature + "\n";
+        writeText(dir + "/src/module" + std::to_string(i) + ".rs", text);
+        if (i % 10 == 0) writeText(dir + "/logs/run" + std::to_string(i) + ".log", text);
+    }
+    std::string grep = "cd " + dir + " && find . -name '*.log' -exec tail -n 10 {} \\; > /dev/null && grep -r '" + signature + "' ./src/ > /dev/null";
+    runBench("find | tail + grep -r via shell (200 x 64KB)", 1, 10, [&] { std::system(grep.c_str()); });
+    WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()));
+    DebugScanOptions options;
+    options.root = dir;
+    DebugScanResult result;
+    runBench("DebugScanner cold (200 x 64KB)", 1, 10, [&] {
+        DebugScanner scanner(options, pool);
+        scanner.scan(signature, result);
+    });
+    DebugScanner scanner(options, pool);
+    scanner.scan(signature, result);
+    runBench("DebugScanner repeat, nothing changed", 3, 50, [&] { scanner.scan(signature, result); });
+    std::string text = makeSummaryText(4 * 1024 * 1024, 3) + signature;
+    volatile size_t sink = 0;
+    runBench("findSubstring 4MB", 3, 50, [&] { sink = sink + static_cast<size_t>(findSubstring(text.data(), text.size(), signature) - text.data()); });
+    runBench("std::string::find 4MB", 3, 50, [&] { sink = sink + text.find(signature); });
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void benchPhaseSimulator() {
+    std::cout << "--- Phase state machine simulation ---" << std::endl;
+    benchGroup = "simulation";
+    SimulationOptions options;
+    options.trajectories = 200000;
+    std::vector<size_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+    for (size_t threads : threadCounts) {
+        PhaseSimulator simulator(threads);
+        runBench("200k trajectories, " + std::to_string(threads) + " thread(s)", 1, 5, [&] { simulator.run(SimulationParameters(), options); });
+    }
+}
+
+void benchConfig() {
+    std::cout << "--- ProgramConfig load/save ---" << std::endl;
+    std::string dir = makeTempDir();
+    std::string path = dir + "/config.json";
+    for (size_t summaryBytes : {size_t{256}, size_t{4} << 20}) {
+        benchGroup = summaryBytes < 1024 ? "config small" : "config 4MB";
+        std::cout << " " << benchGroup << std::endl;
+        ProgramConfig config;
+        config.researchTopic = ResearchTopic::fromLegacy("deepen_fix_deepen_general_knowledge");
+        config.researchIteration = 12;
+        config.currentPhase = ProgramPhase::RESEARCH_CYCLE;
+        config.researchCompletenessScore = 87.5;
+        config.lastResearchSummary = makeSummaryText(summaryBytes, 3);
+        int reps = summaryBytes > 65536 ? 20 : 500;
+        ProgramConfig loaded;
+        runBench("legacy save (ofstream + toJsonString)", reps / 10, reps, [&] { legacySaveConfig(path, config); });
+        runBench("legacy load (ifstream + parseJson)", reps / 10, reps, [&] { legacyLoadConfig(path, loaded); });
+        runBench("ProgramConfig::save (atomic)", reps / 10, reps, [&] { config.save(path); });
+        runBench("ProgramConfig::load", reps / 10, reps, [&] { loaded.load(path); });
+        check(loaded.lastResearchSummary == config.lastResearchSummary && loaded.researchIteration == 12, "config round trip");
+    }
+    std::system(("rm -rf " + dir).c_str());
+}
+
+// Researcher replies built to stress the parser: deep nesting, escape-heavy
+// text, an 8 MB string, many members, log noise around the object and a
+// truncated reply.
+void benchAdversarialOutputs() {
+    std::cout << "--- Adversarial researcher outputs ---" << std::endl;
+    struct Case {
+        std::string name;
+        std::string text;
+        bool valid;
+    };
+    std::vector<Case> cases;
+    cases.push_back({"nested 200 deep", "{\"research_summary\": \"x\", \"nested\": " + std::string(200, '[') + std::string(200, ']') + "}", true});
+    cases.push_back({"nested past the depth limit", "{\"nested\": " + std::string(5000, '[') + std::string(5000, ']') + "}", false});
+    std::string escapes;
+    while (escapes.size() < (1u << 20)) escapes += "\\\"q\\\" \\\\ \\n\\t\\u00e9\\ud83d\\ude00 ";
+    cases.push_back({"1 MB of escapes", "{\"research_summary\": \"" + escapes + "\", \"error_found\": false}", true});
+    cases.push_back({"8 MB summary", makeResearcherOutput(8u << 20, 5), true});
+    std::string members = "{";
+    for (int i = 0; i < 100000; ++i) members += (i ? ", \"k" : "\"k") + std::to_string(i) + "\": " + std::to_string(i);
+    cases.push_back({"100k members", members + "}", true});
+    std::string truncated = makeResearcherOutput(65536, 6);
+    cases.push_back({"truncated 64 KB reply", truncated.substr(0, truncated.size() - 10), false});
+
+    JsonDocument doc;
+    volatile size_t sink = 0;
+    for (const Case& c : cases) {
+        benchGroup = "adversarial " + c.name;
+        std::cout << " " << c.name << " (" << c.text.size() << " bytes)" << std::endl;
+        check(doc.parse(c.text) == c.valid, "adversarial case '" + c.name + "' parses as expected");
+        int reps = static_cast<int>(std::max<size_t>(5, std::min<size_t>(500, (32u << 20) / c.text.size())));
+        runBench("legacy parseJson", 1, std::max(3, reps / 5), [&] { sink = sink + legacyParseJson(c.text).size(); });
+        runBench("JsonDocument::parse", reps / 10, reps, [&] { sink = sink + doc.parse(c.text); });
+    }
+
+    // Log noise (including braces) before and after the object, fed in 4 KB chunks.
+    std::string noisy;
+    for (int i = 0; noisy.size() < (64u << 10); ++i) noisy += "[researcher] step " + std::to_string(i) + " state={partial} ok\n";
+    std::string reply = makeResearcherOutput(16384, 8);
+    noisy += reply + "\n[researcher] done {exit=0}\n";
+    benchGroup = "adversarial log noise";
+    std::cout << " log noise around a 16 KB reply (" << noisy.size() << " bytes)" << std::endl;
+    JsonStreamScanner scanner;
+    std::string received;
+    runBench("JsonStreamScanner (4 KB chunks)", 20, 200, [&] {
+        scanner.reset();
+        received.clear();
+        for (size_t offset = 0; offset < noisy.size() && !scanner.complete(); offset += 4096) {
+            received.append(noisy, offset, 4096);
+            scanner.feed(received);
+        }
+    });
+    check(scanner.complete() && scanner.object(received) == reply, "scanner finds the reply inside log noise");
+}
+
+// Topics grow by one prefix per deepen/fix step; the question loop strips
+// them all again with three replaceAll passes.
+void benchTopics() {
+    std::cout << "--- Long prefixed topics ---" << std::endl;
+    static const char* prefixes[] = {"deepen_", "fix_", "deepen_", "refine_"};
+    volatile size_t sink = 0;
+    for (int depth : {10, 100, 1000}) {
+        benchGroup = "topic " + std::to_string(depth) + " prefixes";
+        std::string topic = "general_knowledge";
+        for (int i = 0; i < depth; ++i) topic = prefixes[i % 4] + topic;
+        std::cout << " " << depth << " prefixes (" << topic.size() << " bytes)" << std::endl;
+        int reps = depth >= 1000 ? 50 : 500;
+        runBench("strip prefixes (replaceAll x3)", reps / 10, reps, [&] {
+            sink = sink + legacyReplaceAll(legacyReplaceAll(legacyReplaceAll(topic, "deepen_", ""), "fix_", ""), "refine_", "").size();
+        });
+        runBench("add a prefix (\"deepen_\" + topic)", reps / 10, reps, [&] {
+            std::string next = "deepen_" + topic;
+            sink = sink + next.size();
+        });
+        ResearchTopic lineage = ResearchTopic::fromLegacy(topic);
+        runBench("ResearchTopic::base", reps / 10, reps, [&] { sink = sink + lineage.base().size(); });
+        runBench("ResearchTopic::push + legacy()", reps / 10, reps, [&] {
+            ResearchTopic next = lineage;
+            next.push(TopicOp::DEEPEN);
+            sink = sink + next.legacy().size();
+        });
+        ProgramConfig config;
+        config.researchTopic = lineage;
+        std::string json;
+        runBench("ProgramConfig::toJson", reps / 10, reps, [&] {
+            config.toJson(json);
+            sink = sink + json.size();
+        });
+    }
+}
+
+std::string absolutePath(const std::string& path) {
+    char* resolved = realpath(path.c_str(), nullptr);
+    if (!resolved) return path;
+    std::string result = resolved;
+    free(resolved);
+    return result;
+}
+
+// Complete state machine runs against the stub researcher with virtual
+// pacing (no sleeping) and a fixed seed, each from an empty directory.
+void benchEndToEnd(const std::string& orchestratorPath, const std::string& stubPath) {
+    std::cout << "--- End-to-end orchestrator run (stub researcher, virtual pacing) ---" << std::endl;
+    benchGroup = "end-to-end";
+    std::string dir = makeTempDir();
+    std::string orchestrator = absolutePath(orchestratorPath);
+    std::string stub = absolutePath(stubPath);
+    SubprocessOptions options;
+    options.timeout = std::chrono::seconds(60);
+    SubprocessResult result;
+    int run = 0;
+    int completed = 0;
+    int runs = 0;
+    for (bool persistent : {false, true}) {
+        runBench(persistent ? "full run, persistent researcher" : "full run, one-shot researcher", 1, 10, [&] {
+            std::string runDir = dir + "/run" + std::to_string(run++);
+            std::string script = "mkdir -p '" + runDir + "' && cd '" + runDir + "' && exec '" + orchestrator + "' --researcher '" + stub +
+                                 "' --pacing virtual --seed 7 --quiet --no-cache --metrics-file ''" + (persistent ? " --persistent-researcher" : "") +
+                                 " < /dev/null > /dev/null 2>&1";
+            runSubprocess({"/bin/sh", "-c", script}, options, result);
+            ProgramConfig final;
+            ++runs;
+            if (result.succeeded() && final.load(runDir + "/config.json") && final.currentPhase == ProgramPhase::QUESTION_ANSWERING) ++completed;
+        });
+    }
+    check(completed == runs, "end-to-end runs reach QUESTION_ANSWERING (" + std::to_string(completed) + "/" + std::to_string(runs) + ")");
+
+    // The same work for 32 sessions: one process each, one after another,
+    // against a single daemon. Scaled pacing leaves real pauses to overlap.
+    const int sessions = 32;
+    completed = 0;
+    runs = 0;
+    runBench("32 sessions, sequential processes, 1000x pacing", 0, 3, [&] {
+        for (int i = 0; i < sessions; ++i) {
+            std::string runDir = dir + "/run" + std::to_string(run++);
+            std::string script = "mkdir -p '" + runDir + "' && cd '" + runDir + "' && exec '" + orchestrator + "' --researcher '" + stub +
+                                 "' --pacing 1000x --seed " + std::to_string(i) + " --quiet --no-cache --metrics-file '' < /dev/null > /dev/null 2>&1";
+            runSubprocess({"/bin/sh", "-c", script}, options, result);
+            ++runs;
+            if (result.succeeded()) ++completed;
+        }
+    });
+    runBench("32 sessions, one daemon, 1000x pacing", 0, 3, [&] {
+        std::string runDir = dir + "/daemon" + std::to_string(run++);
+        std::string script = "mkdir -p '" + runDir + "/sessions' && cd '" + runDir + "' && for i in $(seq 1 " + std::to_string(sessions) +
+                             "); do mkdir sessions/s$i; done && exec '" + orchestrator + "' --daemon sessions --researcher '" + stub +
+                             "' --pacing 1000x --seed 0 --quiet --no-cache --metrics-file '' < /dev/null > /dev/null 2>&1";
+        runSubprocess({"/bin/sh", "-c", script}, options, result);
+        runs += sessions;
+        if (result.succeeded()) completed += sessions;
+    });
+    check(completed == runs, "multi-session runs complete (" + std::to_string(completed) + "/" + std::to_string(runs) + ")");
+    std::system(("rm -rf " + dir).c_str());
+}
+
+int main(int argc, char* argv[]) {
+    std::string stubPath = "./stub_researcher";
+    std::string orchestratorPath = "./orchestrator";
+    std::string outputPath = "bench_output.txt";
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stub") stubPath = argv[++i];
+        else if (arg == "--orchestrator") orchestratorPath = argv[++i];
+        else if (arg == "--output") outputPath = argv[++i];
+    }
+
+    testJsonEdgeCases();
+    testFraming();
+    testSubprocess();
+    testStateJournal();
+    testResearchTopic();
+    testPacer();
+    testWorkStealingPool();
+    testFanOut();
+    testResearchDaemon();
+    testPhaseSimulator();
+    testDebugScanner();
+    testValidationRunner();
+    testResultCache();
+    testKnowledgeBase();
+    testQuestionServer();
+    testLogger();
+    testMetrics();
+    benchJson();
+    benchConfig();
+    benchAdversarialOutputs();
+    benchTopics();
+    benchStateJournal();
+    benchKnowledgeBase();
+    benchQuestionServer();
+    benchLogger();
+    benchMetrics();
+    benchPhaseSimulator();
+    benchDebugScanner();
+    if (access(stubPath.c_str(), X_OK) == 0) {
+        testResearcherWorker(stubPath);
+        testWorkerTimeout(stubPath);
+        benchSubprocess(stubPath);
+        benchFanOut(stubPath);
+        if (access(orchestratorPath.c_str(), X_OK) == 0) {
+            benchEndToEnd(orchestratorPath, stubPath);
+        } else {
+            std::cout << "Skipping end-to-end run: '" << orchestratorPath << "' not found (use --orchestrator <path>)." << std::endl;
+        }
+    } else {
+        std::cout << "Skipping researcher worker tests: '" << stubPath << "' not found (use --stub <path>)." << std::endl;
+    }
+    if (writeBenchResults(outputPath)) {
+        std::cout << benchResults.size() << " benchmark results written to '" << outputPath << "'." << std::endl;
+    } else {
+        std::cerr << "Error: Could not write benchmark results to '" << outputPath << "'." << std::endl;
+        ++failures;
+    }
+    if (failures != 0) {
+        std::cerr << failures << " check(s) failed." << std::endl;
+        return 1;
+    }
+    std::cout << "All checks passed." << std::endl;
+    return 0;
+}
@@ -0,0 +1,237 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "json.h"
+#include "program_config.h"
+#include "result_cache.h"
+#include "subprocess.h"
+#include "work_pool.h"
+
+// One independently runnable test command and the files it depends on.
+struct ValidationUnit {
+    std::string name;
+    std::vector<std::string> command;
+    std::vector<std::string> inputs; // files or directories, relative to the manifest
+    std::chrono::milliseconds timeout{0};
+};
+
+enum class ShardStatus { PASSED, CACHED, FAILED, TIMED_OUT, CANCELLED, SKIPPED };
+
+inline const char* shardStatusToString(ShardStatus status) {
+    switch (status) {
+        case ShardStatus::PASSED: return "passed";
+        case ShardStatus::CACHED: return "cached";
+        case ShardStatus::FAILED: return "failed";
+        case ShardStatus::TIMED_OUT: return "timed_out";
+        case ShardStatus::CANCELLED: return "cancelled";
+        case ShardStatus::SKIPPED: return "skipped";
+    }
+    return "unknown";
+}
+
+struct ValidationShard {
+    ShardStatus status = ShardStatus::SKIPPED;
+    std::chrono::milliseconds elapsed{0};
+    std::string detail; // failure description and the unit's stderr
+    uint64_t inputHash = 0;
+};
+
+struct ValidationReport {
+    std::vector<ValidationShard> shards; // in manifest order
+    bool passed = false;
+    size_t cached = 0;
+    size_t ran = 0;
+    int firstFailure = -1; // lowest-indexed failed or timed out unit
+};
+
+// VALIDATION_TESTS against a manifest, in place of the modelled
+// `cargo test --workspace -- --test-threads=1` and its random outcome:
+//
+//   {"timeout": 120,
+//    "units": [{"name": "parser", "command": ["cargo", "test", "-p", "parser"],
+//               "inputs": ["parser/src", "Cargo.lock"], "timeout": 60}, ...]}
+//
+// A string command runs under /bin/sh -c. Commands run in the manifest's
+// directory and inputs are relative to it. Each unit is keyed by a hash of
+// its command and the contents of its inputs (directories walked in name
+// order, dot-entries skipped). A unit that passed with the same hash is not
+// run again; the rest run as shards on the pool, each with its own timeout.
+// The first failure cancels the shards still running and skips those not yet
+// started. Passing hashes persist in `.validation_cache.json` beside the
+// manifest.
+class ValidationRunner {
+public:
+    ValidationRunner(std::string manifestFile, WorkStealingPool& workers)
+        : manifestPath(std::move(manifestFile)), pool(workers) {
+        size_t slash = manifestPath.rfind('/');
+        root = slash == std::string::npos ? "." : manifestPath.substr(0, slash);
+        cachePath = root + "/.validation_cache.json";
+    }
+
+    static bool exists(const std::string& path) {
+        struct stat info;
+        return ::stat(path.c_str(), &info) == 0;
+    }
+
+    // Reads the manifest and the pass cache. `error` explains a false return.
+    bool load(std::string& error) {
+        std::string contents;
+        if (!readFile(manifestPath, contents)) {
+            error = "Validation manifest '" + manifestPath + "' cannot be read";
+            return false;
+        }
+        JsonDocument doc;
+        if (!doc.parse(contents) || !doc.root()["units"].isArray()) {
+            error = "Validation manifest '" + manifestPath + "' is not a JSON object with a \"units\" array";
+            return false;
+        }
+        auto seconds = [](JsonRef value, std::chrono::milliseconds fallback) {
+            return value ? std::chrono::milliseconds(static_cast<long long>(value.asNumber(0.0) * 1000.0)) : fallback;
+        };
+        std::chrono::milliseconds defaultTimeout = seconds(doc.root()["timeout"], std::chrono::milliseconds(120000));
+        units.clear();
+        doc.root()["units"].forEachElement([&](JsonRef entry) {
+            ValidationUnit unit;
+            unit.name.assign(entry["name"].asString());
+            JsonRef command = entry["command"];
+            if (command.isArray()) command.forEachElement([&](JsonRef arg) { unit.command.emplace_back(arg.asString()); });
+            else if (command.isString()) unit.command = {"/bin/sh", "-c", std::string(command.asString())};
+            if (!unit.command.empty()) unit.command.insert(unit.command.begin(), {"/bin/sh", "-c", "cd \"$0\" && exec \"$@\"", root});
+            entry["inputs"].forEachElement([&](JsonRef input) { unit.inputs.emplace_back(input.asString()); });
+            unit.timeout = seconds(entry["timeout"], defaultTimeout);
+            units.push_back(std::move(unit));
+        });
+        for (const ValidationUnit& unit : units) {
+            if (unit.name.empty() || unit.command.empty()) {
+                error = "Validation manifest '" + manifestPath + "' has a unit without a name or command";
+                return false;
+            }
+        }
+
+        passedHashes.clear();
+        if (readFile(cachePath, contents) && doc.parse(contents)) {
+            doc.root().forEachMember([&](std::string_view name, JsonRef hash) {
+                passedHashes[std::string(name)] = std::strtoull(std::string(hash.asString()).c_str(), nullptr, 16);
+            });
+        }
+        return true;
+    }
+
+    const std::vector<ValidationUnit>& manifest() const { return units; }
+
+    void run(ValidationReport& report) {
+        report.shards.assign(units.size(), ValidationShard());
+        std::atomic<bool> failed{false};
+        pool.parallelFor(units.size(), [&](size_t i) { runShard(units[i], report.shards[i], failed); });
+
+        report.cached = report.ran = 0;
+        report.firstFailure = -1;
+        bool cacheChanged = false;
+        for (size_t i = 0; i < units.size(); ++i) {
+            const ValidationShard& shard = report.shards[i];
+            if (shard.status == ShardStatus::CACHED) ++report.cached;
+            if (shard.status == ShardStatus::PASSED || shard.status == ShardStatus::FAILED || shard.status == ShardStatus::TIMED_OUT) ++report.ran;
+            if (shard.status == ShardStatus::PASSED) {
+                passedHashes[units[i].name] = shard.inputHash;
+                cacheChanged = true;
+            } else if (shard.status == ShardStatus::FAILED || shard.status == ShardStatus::TIMED_OUT) {
+                if (report.firstFailure < 0) report.firstFailure = static_cast<int>(i);
+                cacheChanged |= passedHashes.erase(units[i].name) > 0;
+            }
+        }
+        report.passed = report.firstFailure < 0;
+        if (cacheChanged) saveCache();
+    }
+
+private:
+    // Runs on a pool thread; touches only `unit`, `shard` and `failed`.
+    void runShard(const ValidationUnit& unit, ValidationShard& shard, std::atomic<bool>& failed) const {
+        if (failed.load(std::memory_order_relaxed)) return;
+        shard.inputHash = hashUnit(unit);
+        auto cached = passedHashes.find(unit.name);
+        if (cached != passedHashes.end() && cached->second == shard.inputHash) {
+            shard.status = ShardStatus::CACHED;
+            return;
+        }
+        if (failed.load(std::memory_order_relaxed)) return;
+        SubprocessOptions spawnOptions;
+        spawnOptions.timeout = unit.timeout;
+        spawnOptions.cancel = &failed;
+        SubprocessResult run;
+        runSubprocess(unit.command, spawnOptions, run);
+        shard.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(run.elapsed);
+        if (run.succeeded()) {
+            shard.status = ShardStatus::PASSED;
+            return;
+        }
+        if (run.cancelled) {
+            shard.status = ShardStatus::CANCELLED;
+            return;
+        }
+        shard.status = run.timedOut ? ShardStatus::TIMED_OUT : ShardStatus::FAILED;
+        shard.detail = run.describeFailure("Validation unit '" + unit.name + "'");
+        if (!run.errors.empty()) shard.detail += ":\n" + run.errors;
+        failed.store(true, std::memory_order_relaxed);
+    }
+
+    uint64_t hashUnit(const ValidationUnit& unit) const {
+        uint64_t hash = fnv1a64("");
+        for (const std::string& arg : unit.command) hash = fnv1a64(std::string_view(arg.c_str(), arg.size() + 1), hash);
+        std::string contents;
+        for (const std::string& input : unit.inputs) hashPath(input, hash, contents);
+        return hash;
+    }
+
+    void hashPath(const std::string& relative, uint64_t& hash, std::string& contents) const {
+        std::string path = root + "/" + relative;
+        hash = fnv1a64(std::string_view(relative.c_str(), relative.size() + 1), hash);
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0) {
+            hash = fnv1a64("<missing>", hash);
+            return;
+        }
+        if (!S_ISDIR(info.st_mode)) {
+            if (readFile(path, contents)) hash = fnv1a64(contents, hash);
+            return;
+        }
+        std::vector<std::string> names;
+        if (DIR* dir = ::opendir(path.c_str())) {
+            while (dirent* entry = ::readdir(dir)) {
+                if (entry->d_name[0] != '.') names.emplace_back(entry->d_name);
+            }
+            ::closedir(dir);
+        }
+        std::sort(names.begin(), names.end());
+        for (const std::string& name : names) hashPath(relative + "/" + name, hash, contents);
+    }
+
+    void saveCache() const {
+        std::string out;
+        JsonWriter writer(out);
+        writer.beginObject();
+        std::vector<std::pair<std::string, uint64_t>> sorted(passedHashes.begin(), passedHashes.end());
+        std::sort(sorted.begin(), sorted.end());
+        for (const auto& entry : sorted) writer.member(entry.first, toHex64(entry.second));
+        writer.endObject();
+        if (!writeFileAtomically(cachePath, out)) {
+            std::cerr << "Error: Could not write validation cache '" << cachePath << "'." << std::endl;
+        }
+    }
+
+    std::string manifestPath;
+    std::string root;
+    std::string cachePath;
+    WorkStealingPool& pool;
+    std::vector<ValidationUnit> units;
+    std::unordered_map<std::string, uint64_t> passedHashes;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker. parallelFor()
+// deals tasks round-robin onto the deques; a worker takes from the back of
+// its own deque and, once that is empty, steals from the front of the
+// others', so a few slow tasks (a researcher that hangs until its timeout)
+// do not leave the rest of the batch queued behind them.
+//
+// Only one parallelFor() runs at a time; the pool never grows, so the
+// number of concurrent tasks is bounded by size().
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(size_t threads) : queues(std::max<size_t>(1, threads)) {
+        for (auto& queue : queues) queue = std::make_unique<Queue>();
+        for (size_t i = 0; i < queues.size(); ++i) workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            stopping = true;
+        }
+        idle.notify_all();
+        for (std::thread& worker : workers) worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t size() const { return queues.size(); }
+
+    // Tasks taken from another worker's deque since construction.
+    uint64_t steals() const { return stolen.load(std::memory_order_relaxed); }
+
+    // Calls task(i) for every i in [0, count) on the pool and returns once
+    // all have finished. Tasks must not throw.
+    void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+        if (count == 0) return;
+        {
+            std::lock_guard<std::mutex> lock(batchMutex);
+            remaining = count;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            Queue& queue = *queues[i % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back([&task, i] { task(i); });
+        }
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            queued.fetch_add(static_cast<int64_t>(count), std::memory_order_relaxed);
+        }
+        idle.notify_all();
+        std::unique_lock<std::mutex> lock(batchMutex);
+        batchDone.wait(lock, [&] { return remaining == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool take(size_t self, std::function<void()>& task) {
+        {
+            Queue& own = *queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); ++offset) {
+            Queue& victim = *queues[(self + offset) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t self) {
+        std::function<void()> task;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(idleMutex);
+                idle.wait(lock, [&] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+                if (stopping) return;
+            }
+            while (take(self, task)) {
+                task();
+                task = nullptr;
+                bool last;
+                {
+                    std::lock_guard<std::mutex> lock(batchMutex);
+                    last = --remaining == 0;
+                }
+                if (last) batchDone.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> stolen{0};
+
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    // Tasks pushed but not yet taken. Raised only once a batch is fully
+    // pushed, so it can dip below zero while workers race ahead of it.
+    std::atomic<int64_t> queued{0};
+    bool stopping = false;
+
+    std::mutex batchMutex;
+    std::condition_variable batchDone;
+    size_t remaining = 0;
+};